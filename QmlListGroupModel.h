@@ -0,0 +1,510 @@
+#ifndef QMLLISTGROUPMODEL_H
+#define QMLLISTGROUPMODEL_H
+
+#include "QmlListModel.h"
+
+/**
+ * @brief The QmlListGroupModel class groups the rows of a source model by one role.
+ * It exposes a flattened list, a header row for every group followed by its member rows,
+ * ordered by the group key. The groups keep the source rows in a hash of key to row list
+ * and follow the insertions, removals and changes of the source incrementally.
+ * An insertion or removal renumbers only the groups it touches and logs the shift of
+ * the rows after it; every other group applies the logged shifts when it is next read,
+ * and the log is folded into all the groups once it holds MaxShifts entries.
+ * Switching the group role re-reads the keys; for a QmlListModel source only the key
+ * property is read on the model thread and converted to keys in parallel.
+ */
+class QmlListGroupModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QAbstractItemModel* sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+    Q_PROPERTY(QString groupRole READ groupRole WRITE setGroupRole NOTIFY groupRoleChanged)
+    Q_PROPERTY(int groupCount READ groupCount NOTIFY groupCountChanged)
+public:
+    enum GroupRoles {
+        GroupKeyRole = Qt::UserRole + 1000,
+        GroupCountRole,
+        GroupHeaderRole,
+        GroupCollapsedRole
+    };
+
+    explicit QmlListGroupModel(QObject *parent = 0):
+        QAbstractListModel(parent), mSource(Q_NULLPTR), mRole(-1){}
+
+    inline QAbstractItemModel* sourceModel() const {
+        return mSource;
+    }
+
+    void setSourceModel(QAbstractItemModel* source){
+        if(mSource == source)
+            return;
+        if(mSource != Q_NULLPTR)
+            mSource->disconnect(this);
+        mSource = source;
+        if(mSource != Q_NULLPTR){
+            connect(mSource, &QAbstractItemModel::rowsInserted, this, &QmlListGroupModel::onRowsInserted);
+            connect(mSource, &QAbstractItemModel::rowsRemoved, this, &QmlListGroupModel::onRowsRemoved);
+            connect(mSource, &QAbstractItemModel::dataChanged, this, &QmlListGroupModel::onDataChanged);
+            connect(mSource, &QAbstractItemModel::modelReset, this, &QmlListGroupModel::rebuild);
+            connect(mSource, &QAbstractItemModel::layoutChanged, this, &QmlListGroupModel::rebuild);
+            connect(mSource, &QAbstractItemModel::rowsMoved, this, &QmlListGroupModel::rebuild);
+            connect(mSource, &QObject::destroyed, this, [this](){ mSource = Q_NULLPTR; rebuild(); });
+        }
+        rebuild();
+        emit sourceModelChanged();
+    }
+
+    inline QString groupRole() const {
+        return mRoleName;
+    }
+
+    void setGroupRole(const QString& role){
+        if(mRoleName == role)
+            return;
+        mRoleName = role;
+        rebuild();
+        emit groupRoleChanged();
+    }
+
+    inline int groupCount() const {
+        return mOrder.size();
+    }
+
+    /**
+     * @brief groupKeys
+     * @return The group keys in order
+     */
+    Q_INVOKABLE inline QStringList groupKeys() const {
+        return mOrder.toList();
+    }
+
+    /**
+     * @brief groupSize
+     * @param key
+     * @return The count of source rows in the group
+     */
+    Q_INVOKABLE inline int groupSize(const QString& key) const {
+        const Group* g = group(key);
+        return g == Q_NULLPTR ? 0 : g->rows.size();
+    }
+
+    /**
+     * @brief groupRows
+     * @param key
+     * @return The source rows of the group
+     */
+    Q_INVOKABLE inline QVariantList groupRows(const QString& key) const {
+        QVariantList rows;
+        const Group* g = group(key);
+        if(g == Q_NULLPTR)
+            return rows;
+        for(int r : g->rows)
+            rows.append(r);
+        return rows;
+    }
+
+    /**
+     * @brief setCollapsed hides or shows the member rows of a group
+     * @param key
+     * @param collapsed
+     */
+    Q_INVOKABLE void setCollapsed(const QString& key, bool collapsed){
+        auto it = mGroups.find(key);
+        if(it == mGroups.end() || it->collapsed == collapsed || it->rows.isEmpty())
+            return;
+        const int header = mStarts.at(position(key));
+        if(collapsed){
+            beginRemoveRows(QModelIndex(), header + 1, header + it->rows.size());
+            it->collapsed = true;
+            updateStarts();
+            endRemoveRows();
+        } else {
+            beginInsertRows(QModelIndex(), header + 1, header + it->rows.size());
+            it->collapsed = false;
+            updateStarts();
+            endInsertRows();
+        }
+        emit dataChanged(index(header), index(header), QVector<int>() << GroupCollapsedRole);
+    }
+
+    Q_INVOKABLE inline void toggleCollapsed(const QString& key){
+        setCollapsed(key, !mGroups.value(key).collapsed);
+    }
+
+    /**
+     * @brief sourceRow
+     * @param row
+     * @return The source row of a member row, -1 for a header
+     */
+    Q_INVOKABLE inline int sourceRow(int row) const {
+        int g, member;
+        locate(row, &g, &member);
+        return (g < 0 || member < 0) ? -1 : group(mOrder.at(g))->rows.at(member);
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        Q_UNUSED(parent);
+        return mOrder.isEmpty() ? 0 : mStarts.last() + visibleSize(mOrder.last());
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        int g, member;
+        locate(index.row(), &g, &member);
+        if(g < 0)
+            return QVariant();
+        const QString& key = mOrder.at(g);
+        switch (role) {
+        case GroupKeyRole:
+            return key;
+        case GroupCountRole:
+            return mGroups.value(key).rows.size();
+        case GroupHeaderRole:
+            return member < 0;
+        case GroupCollapsedRole:
+            return mGroups.value(key).collapsed;
+        default: {
+            const int row = member < 0 ? -1 : group(key)->rows.at(member);
+            if(row < 0 || mSource == Q_NULLPTR)
+                return QVariant();
+            return mSource->data(mSource->index(row, 0), role);
+        }
+        }
+    }
+
+    QHash<int, QByteArray> roleNames() const override {
+        QHash<int, QByteArray> roles;
+        if(mSource != Q_NULLPTR)
+            roles = mSource->roleNames();
+        roles[GroupKeyRole] = "groupKey";
+        roles[GroupCountRole] = "groupCount";
+        roles[GroupHeaderRole] = "isGroupHeader";
+        roles[GroupCollapsedRole] = "collapsed";
+        return roles;
+    }
+
+signals:
+    void sourceModelChanged();
+    void groupRoleChanged();
+    void groupCountChanged();
+
+private:
+    /**
+     * @brief The Group struct is the sorted source rows of a group, current up to
+     * the first synced shifts of the log, the reads apply the others
+     */
+    struct Group {
+        mutable QVector<int>    rows;
+        mutable int             synced = 0;
+        bool                    collapsed = false;
+    };
+
+    /**
+     * @brief The Shift struct adds delta to the source rows from from on
+     */
+    struct Shift {
+        int from;
+        int delta;
+    };
+
+    /**
+     * @brief Shifts logged at most before they are applied to every group
+     */
+    static const int MaxShifts = 256;
+
+    /**
+     * @brief rebuild reads the keys of all source rows. For a QmlListModel the key property
+     * is read on the model thread and converted concurrently, any other source is read by data().
+     */
+    void rebuild(){
+        beginResetModel();
+        const int oldGroups = mOrder.size();
+        QHash<QString, bool> collapsed;
+        for(auto it = mGroups.constBegin(); it != mGroups.constEnd(); ++it)
+            collapsed.insert(it.key(), it->collapsed);
+        mGroups.clear();
+        mOrder.clear();
+        mKeys.clear();
+        mShifts.clear();
+        mRole = mSource == Q_NULLPTR ? -1 : mSource->roleNames().key(mRoleName.toUtf8(), -1);
+        if(mRole >= 0){
+            const int count = mSource->rowCount();
+            mKeys.resize(count);
+            QAbstractBase* base = dynamic_cast<QAbstractBase*>(mSource);
+            if(base != Q_NULLPTR && base->rowMetaObject() != Q_NULLPTR){
+                /**
+                  * The role of a QmlListModel is the index of its property
+                  */
+                const QMetaProperty& p = base->rowMetaObject()->property(mRole);
+                QVector<QVariant> values(count);
+                for(int i = 0; i < count; ++i){
+                    const QObject* obj = base->rowObject(i);
+                    if(obj != Q_NULLPTR)
+                        values[i] = p.read(obj);
+                }
+                QString* keys = mKeys.data();
+                QmlListModelParallel::run((count + 4095) / 4096, QThread::idealThreadCount(), [&](int k){
+                    for(int i = k * 4096; i < qMin(count, (k + 1) * 4096); ++i)
+                        keys[i] = values.at(i).toString();
+                });
+            } else {
+                for(int i = 0; i < count; ++i)
+                    mKeys[i] = keyOf(i);
+            }
+            for(int i = 0; i < count; ++i)
+                mGroups[mKeys.at(i)].rows.append(i);
+            for(auto it = mGroups.begin(); it != mGroups.end(); ++it){
+                it->collapsed = collapsed.value(it.key(), false);
+                mOrder.append(it.key());
+            }
+            std::sort(mOrder.begin(), mOrder.end());
+        }
+        updateStarts();
+        endResetModel();
+        if(oldGroups != mOrder.size())
+            emit groupCountChanged();
+    }
+
+    void onRowsInserted(const QModelIndex& parent, int first, int last){
+        if(parent.isValid() || mRole < 0)
+            return;
+        const int count = last - first + 1;
+        foldShifts();
+        mShifts.append(Shift{first, count});
+        mKeys.insert(first, count, QString());
+        for(int i = first; i <= last; ++i){
+            mKeys[i] = keyOf(i);
+            insertMember(i, mKeys.at(i));
+        }
+    }
+
+    void onRowsRemoved(const QModelIndex& parent, int first, int last){
+        if(parent.isValid() || mRole < 0)
+            return;
+        const int count = last - first + 1;
+        foldShifts();
+        /**
+          * Find the members of the removed rows, then shift their groups to the source as it is now,
+          * the removed members read as -1 until their own removal is emitted.
+          * The other groups hold no removed row and take the shift from the log.
+          */
+        QVector<QPair<QString, int> > members;
+        members.reserve(count);
+        QSet<QString> touched;
+        for(int i = last; i >= first; --i){
+            const Group* g = group(mKeys.at(i));
+            if(g == Q_NULLPTR)
+                continue;
+            auto r = std::lower_bound(g->rows.constBegin(), g->rows.constEnd(), i);
+            if(r != g->rows.constEnd() && *r == i){
+                members.append(qMakePair(mKeys.at(i), int(r - g->rows.constBegin())));
+                touched.insert(mKeys.at(i));
+            }
+        }
+        mShifts.append(Shift{last + 1, -count});
+        for(const QString& key : touched){
+            const Group& g = mGroups[key];
+            for(int& r : g.rows){
+                if(r > last)
+                    r -= count;
+                else if(r >= first)
+                    r = -1;
+            }
+            g.synced = mShifts.size();
+        }
+        mKeys.remove(first, count);
+        for(const QPair<QString, int>& m : members)
+            removeMemberAt(m.first, m.second);
+    }
+
+    void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles){
+        if(mRole < 0)
+            return;
+        const bool keyChanged = roles.isEmpty() || roles.contains(mRole);
+        for(int i = topLeft.row(); i <= bottomRight.row(); ++i){
+            if(keyChanged){
+                const QString& key = keyOf(i);
+                if(key != mKeys.at(i)){
+                    removeMember(i, mKeys.at(i));
+                    mKeys[i] = key;
+                    insertMember(i, key);
+                    continue;
+                }
+            }
+            const int row = proxyRow(i, mKeys.at(i));
+            if(row >= 0)
+                emit dataChanged(index(row), index(row), roles);
+        }
+    }
+
+    inline QString keyOf(int i) const {
+        return mSource->data(mSource->index(i, 0), mRole).toString();
+    }
+
+    inline int position(const QString& key) const {
+        return int(std::lower_bound(mOrder.constBegin(), mOrder.constEnd(), key) - mOrder.constBegin());
+    }
+
+    inline int visibleSize(const QString& key) const {
+        const Group& g = mGroups.value(key);
+        return 1 + (g.collapsed ? 0 : g.rows.size());
+    }
+
+    /**
+     * @brief group
+     * @param key
+     * @return The group of key with its rows shifted to the source as it is now, null if none
+     */
+    inline const Group* group(const QString& key) const {
+        auto it = mGroups.constFind(key);
+        if(it == mGroups.constEnd())
+            return Q_NULLPTR;
+        sync(it.value());
+        return &it.value();
+    }
+
+    /**
+     * @brief sync applies the logged shifts the group has not applied yet
+     */
+    inline void sync(const Group& g) const {
+        for(; g.synced < mShifts.size(); ++g.synced){
+            const Shift& s = mShifts.at(g.synced);
+            for(auto r = std::lower_bound(g.rows.begin(), g.rows.end(), s.from); r != g.rows.end(); ++r)
+                *r += s.delta;
+        }
+    }
+
+    /**
+     * @brief foldShifts applies a full log to every group and empties it
+     */
+    inline void foldShifts(){
+        if(mShifts.size() < MaxShifts)
+            return;
+        for(auto it = mGroups.begin(); it != mGroups.end(); ++it){
+            sync(it.value());
+            it->synced = 0;
+        }
+        mShifts.clear();
+    }
+
+    inline void updateStarts(){
+        mStarts.resize(mOrder.size());
+        int start = 0;
+        for(int g = 0; g < mOrder.size(); ++g){
+            mStarts[g] = start;
+            start += visibleSize(mOrder.at(g));
+        }
+    }
+
+    /**
+     * @brief locate
+     * @param row Flattened row
+     * @param group Group position, -1 when out of range
+     * @param member Member position, -1 for the header
+     */
+    inline void locate(int row, int* group, int* member) const {
+        *group = -1;
+        *member = -1;
+        if(row < 0 || row >= rowCount())
+            return;
+        *group = int(std::upper_bound(mStarts.constBegin(), mStarts.constEnd(), row) - mStarts.constBegin()) - 1;
+        *member = row - mStarts.at(*group) - 1;
+    }
+
+    inline int proxyRow(int sourceRow, const QString& key) const {
+        const Group* g = group(key);
+        if(g == Q_NULLPTR || g->collapsed)
+            return -1;
+        auto it = std::lower_bound(g->rows.constBegin(), g->rows.constEnd(), sourceRow);
+        if(it == g->rows.constEnd() || *it != sourceRow)
+            return -1;
+        return mStarts.at(position(key)) + 1 + int(it - g->rows.constBegin());
+    }
+
+    void insertMember(int sourceRow, const QString& key){
+        auto it = mGroups.find(key);
+        if(it == mGroups.end()){
+            /**
+              * New group, insert its header with the row
+              */
+            const int g = position(key);
+            const int header = g < mStarts.size() ? mStarts.at(g) : rowCount();
+            beginInsertRows(QModelIndex(), header, header + 1);
+            Group& added = mGroups[key];
+            added.rows.append(sourceRow);
+            added.synced = mShifts.size();
+            mOrder.insert(g, key);
+            updateStarts();
+            endInsertRows();
+            emit groupCountChanged();
+            return;
+        }
+        group(key);
+        QVector<int>& rows = it->rows;
+        const int member = int(std::lower_bound(rows.begin(), rows.end(), sourceRow) - rows.begin());
+        const int header = mStarts.at(position(key));
+        if(it->collapsed){
+            rows.insert(member, sourceRow);
+        } else {
+            beginInsertRows(QModelIndex(), header + 1 + member, header + 1 + member);
+            rows.insert(member, sourceRow);
+            updateStarts();
+            endInsertRows();
+        }
+        emit dataChanged(index(header), index(header), QVector<int>() << GroupCountRole);
+    }
+
+    void removeMember(int sourceRow, const QString& key){
+        const Group* g = group(key);
+        if(g == Q_NULLPTR)
+            return;
+        const QVector<int>& rows = g->rows;
+        auto r = std::lower_bound(rows.constBegin(), rows.constEnd(), sourceRow);
+        if(r == rows.constEnd() || *r != sourceRow)
+            return;
+        removeMemberAt(key, int(r - rows.constBegin()));
+    }
+
+    /**
+     * @brief removeMemberAt removes the member at position member of the group key
+     */
+    void removeMemberAt(const QString& key, int member){
+        auto it = mGroups.find(key);
+        if(it == mGroups.end())
+            return;
+        QVector<int>& rows = it->rows;
+        const int g = position(key);
+        const int header = mStarts.at(g);
+        if(rows.size() == 1){
+            /**
+              * Last row, remove the group with its header
+              */
+            beginRemoveRows(QModelIndex(), header, header + (it->collapsed ? 0 : 1));
+            mGroups.erase(it);
+            mOrder.remove(g);
+            updateStarts();
+            endRemoveRows();
+            emit groupCountChanged();
+            return;
+        }
+        if(it->collapsed){
+            rows.remove(member);
+        } else {
+            beginRemoveRows(QModelIndex(), header + 1 + member, header + 1 + member);
+            rows.remove(member);
+            updateStarts();
+            endRemoveRows();
+        }
+        emit dataChanged(index(header), index(header), QVector<int>() << GroupCountRole);
+    }
+
+    QAbstractItemModel*     mSource;
+    QString                 mRoleName;
+    int                     mRole;
+    QVector<QString>        mKeys;
+    QHash<QString, Group>   mGroups;
+    QVector<QString>        mOrder;
+    QVector<int>            mStarts;
+    QVector<Shift>          mShifts;
+};
+
+#endif // QMLLISTGROUPMODEL_H
@@ -0,0 +1,488 @@
+#ifndef QMLLISTJOINMODEL_H
+#define QMLLISTJOINMODEL_H
+
+#include "QmlListModel.h"
+
+/**
+ * @brief The QmlListJoinModel class shows the rows of a left model enriched with the roles
+ * of the right row of the same key, e.g. a member with the name of its apartment.
+ * It has one row per left row. The rows of both sides are indexed by key in a hash, so every
+ * lookup is O(1), and a change on either side notifies only the joined rows it affects.
+ * The indexes are updated in place: an insert or remove shifts the row numbers after it,
+ * a move remaps the keys of the moved range only.
+ * The right roles are named rightPrefix + their name, a name clashing with a left role is hidden.
+ * When several right rows share a key, the first one is joined.
+ */
+class QmlListJoinModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QAbstractItemModel* leftModel READ leftModel WRITE setLeftModel NOTIFY leftModelChanged)
+    Q_PROPERTY(QAbstractItemModel* rightModel READ rightModel WRITE setRightModel NOTIFY rightModelChanged)
+    Q_PROPERTY(QString leftKey READ leftKey WRITE setLeftKey NOTIFY leftKeyChanged)
+    Q_PROPERTY(QString rightKey READ rightKey WRITE setRightKey NOTIFY rightKeyChanged)
+    Q_PROPERTY(QString rightPrefix READ rightPrefix WRITE setRightPrefix NOTIFY rightPrefixChanged)
+public:
+    enum JoinRoles {
+        JoinedRole = Qt::UserRole + 1000,
+        /**
+          * Right role r is exposed as RightRoleOffset + r
+          */
+        RightRoleOffset = Qt::UserRole + 4096
+    };
+
+    explicit QmlListJoinModel(QObject *parent = 0):
+        QAbstractListModel(parent), mLeft(Q_NULLPTR), mRight(Q_NULLPTR),
+        mLeftRole(-1), mRightRole(-1){}
+
+    inline QAbstractItemModel* leftModel() const {
+        return mLeft;
+    }
+
+    void setLeftModel(QAbstractItemModel* left){
+        if(mLeft == left)
+            return;
+        if(mLeft != Q_NULLPTR)
+            mLeft->disconnect(this);
+        mLeft = left;
+        if(mLeft != Q_NULLPTR){
+            connect(mLeft, &QAbstractItemModel::rowsAboutToBeInserted, this, [this](const QModelIndex& parent, int first, int last){
+                if(!parent.isValid())
+                    beginInsertRows(QModelIndex(), first, last);
+            });
+            connect(mLeft, &QAbstractItemModel::rowsInserted, this, &QmlListJoinModel::onLeftRowsInserted);
+            connect(mLeft, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex& parent, int first, int last){
+                if(!parent.isValid())
+                    beginRemoveRows(QModelIndex(), first, last);
+            });
+            connect(mLeft, &QAbstractItemModel::rowsRemoved, this, &QmlListJoinModel::onLeftRowsRemoved);
+            connect(mLeft, &QAbstractItemModel::rowsAboutToBeMoved, this, [this](const QModelIndex& parent, int first, int last, const QModelIndex&, int to){
+                if(!parent.isValid())
+                    beginMoveRows(QModelIndex(), first, last, QModelIndex(), to);
+            });
+            connect(mLeft, &QAbstractItemModel::rowsMoved, this, &QmlListJoinModel::onLeftRowsMoved);
+            connect(mLeft, &QAbstractItemModel::dataChanged, this, &QmlListJoinModel::onLeftDataChanged);
+            connect(mLeft, &QAbstractItemModel::modelReset, this, &QmlListJoinModel::rebuild);
+            connect(mLeft, &QAbstractItemModel::layoutChanged, this, &QmlListJoinModel::rebuild);
+            connect(mLeft, &QObject::destroyed, this, [this](){ mLeft = Q_NULLPTR; rebuild(); });
+        }
+        rebuild();
+        emit leftModelChanged();
+    }
+
+    inline QAbstractItemModel* rightModel() const {
+        return mRight;
+    }
+
+    void setRightModel(QAbstractItemModel* right){
+        if(mRight == right)
+            return;
+        if(mRight != Q_NULLPTR)
+            mRight->disconnect(this);
+        mRight = right;
+        if(mRight != Q_NULLPTR){
+            connect(mRight, &QAbstractItemModel::rowsInserted, this, &QmlListJoinModel::onRightRowsInserted);
+            connect(mRight, &QAbstractItemModel::rowsRemoved, this, &QmlListJoinModel::onRightRowsRemoved);
+            connect(mRight, &QAbstractItemModel::rowsMoved, this, &QmlListJoinModel::onRightRowsMoved);
+            connect(mRight, &QAbstractItemModel::dataChanged, this, &QmlListJoinModel::onRightDataChanged);
+            connect(mRight, &QAbstractItemModel::modelReset, this, &QmlListJoinModel::rebuild);
+            connect(mRight, &QAbstractItemModel::layoutChanged, this, &QmlListJoinModel::rebuild);
+            connect(mRight, &QObject::destroyed, this, [this](){ mRight = Q_NULLPTR; rebuild(); });
+        }
+        rebuild();
+        emit rightModelChanged();
+    }
+
+    inline QString leftKey() const {
+        return mLeftKeyName;
+    }
+
+    void setLeftKey(const QString& key){
+        if(mLeftKeyName == key)
+            return;
+        mLeftKeyName = key;
+        rebuild();
+        emit leftKeyChanged();
+    }
+
+    inline QString rightKey() const {
+        return mRightKeyName;
+    }
+
+    void setRightKey(const QString& key){
+        if(mRightKeyName == key)
+            return;
+        mRightKeyName = key;
+        rebuild();
+        emit rightKeyChanged();
+    }
+
+    inline QString rightPrefix() const {
+        return mRightPrefix;
+    }
+
+    void setRightPrefix(const QString& prefix){
+        if(mRightPrefix == prefix)
+            return;
+        mRightPrefix = prefix;
+        rebuild();
+        emit rightPrefixChanged();
+    }
+
+    /**
+     * @brief rightRow
+     * @param row
+     * @return The right row joined to row, -1 if none
+     */
+    Q_INVOKABLE inline int rightRow(int row) const {
+        if(row < 0 || row >= mLeftKeys.size() || mLeftRole < 0)
+            return -1;
+        return firstRightRow(mLeftKeys.at(row));
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : mLeftKeys.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        if(index.row() < 0 || index.row() >= mLeftKeys.size())
+            return QVariant();
+        if(role == JoinedRole)
+            return rightRow(index.row()) >= 0;
+        if(role >= RightRoleOffset){
+            const int r = rightRow(index.row());
+            return r < 0 ? QVariant() : mRight->data(mRight->index(r, 0), role - RightRoleOffset);
+        }
+        return mLeft->data(mLeft->index(index.row(), 0), role);
+    }
+
+    QHash<int, QByteArray> roleNames() const override {
+        return mRoleNames;
+    }
+
+signals:
+    void leftModelChanged();
+    void rightModelChanged();
+    void leftKeyChanged();
+    void rightKeyChanged();
+    void rightPrefixChanged();
+
+private:
+    /**
+     * @brief rebuild reads the keys of both sides and indexes the right rows
+     */
+    void rebuild(){
+        beginResetModel();
+        mLeftKeys.clear();
+        mRightKeys.clear();
+        mRightRows.clear();
+        mLeftRows.clear();
+        mRoleNames.clear();
+        mLeftRole = mLeft == Q_NULLPTR ? -1 : mLeft->roleNames().key(mLeftKeyName.toUtf8(), -1);
+        mRightRole = mRight == Q_NULLPTR ? -1 : mRight->roleNames().key(mRightKeyName.toUtf8(), -1);
+        if(mLeft != Q_NULLPTR){
+            mRoleNames = mLeft->roleNames();
+            mLeftKeys.resize(mLeft->rowCount());
+            for(int i = 0; i < mLeftKeys.size(); ++i)
+                mLeftKeys[i] = leftKeyOf(i);
+            insertRows(mLeftRows, mLeftKeys, 0, mLeftKeys.size() - 1);
+        }
+        if(mRight != Q_NULLPTR){
+            const QList<QByteArray>& leftNames = mRoleNames.values();
+            const QHash<int, QByteArray>& rightNames = mRight->roleNames();
+            for(auto it = rightNames.constBegin(); it != rightNames.constEnd(); ++it){
+                const QByteArray& name = mRightPrefix.toUtf8() + it.value();
+                if(!leftNames.contains(name))
+                    mRoleNames.insert(RightRoleOffset + it.key(), name);
+            }
+            if(mRightRole >= 0){
+                mRightKeys.resize(mRight->rowCount());
+                for(int i = 0; i < mRightKeys.size(); ++i)
+                    mRightKeys[i] = rightKeyOf(i);
+                insertRows(mRightRows, mRightKeys, 0, mRightKeys.size() - 1);
+            }
+        }
+        mRoleNames.insert(JoinedRole, "joined");
+        endResetModel();
+    }
+
+    inline QString leftKeyOf(int i) const {
+        return mLeftRole < 0 ? QString() : mLeft->data(mLeft->index(i, 0), mLeftRole).toString();
+    }
+
+    inline QString rightKeyOf(int i) const {
+        return mRight->data(mRight->index(i, 0), mRightRole).toString();
+    }
+
+    typedef QHash<QString, QVector<int> > RowIndex;
+
+    /**
+     * @brief insertRows indexes the rows first to last of keys, which were just inserted.
+     * The rows after them are shifted, the other keys keep their row lists.
+     * @param rows Sorted rows of each key
+     * @param keys Keys including the new rows
+     */
+    static void insertRows(RowIndex& rows, const QVector<QString>& keys, int first, int last){
+        if(last < first)
+            return;
+        shiftRows(rows, first, last - first + 1);
+        for(int i = first; i <= last; ++i)
+            indexRow(rows, keys.at(i), i);
+    }
+
+    /**
+     * @brief removeRows drops the rows first to last from the index and shifts the rows after them
+     * @param rows
+     * @param keys Keys still holding the removed rows
+     */
+    static void removeRows(RowIndex& rows, const QVector<QString>& keys, int first, int last){
+        for(int i = first; i <= last; ++i)
+            unindexRow(rows, keys.at(i), i);
+        shiftRows(rows, last + 1, first - last - 1);
+    }
+
+    /**
+     * @brief moveRows remaps the rows of the keys found between the move bounds,
+     * the rows outside them do not change
+     * @param rows
+     * @param keys Keys before the move
+     */
+    static void moveRows(RowIndex& rows, const QVector<QString>& keys, int first, int last, int to){
+        const int lo = qMin(first, to), hi = qMax(last + 1, to);
+        QSet<QString> moved;
+        for(int i = lo; i < hi; ++i)
+            moved.insert(keys.at(i));
+        for(const QString& key : moved){
+            QVector<int>& list = rows[key];
+            for(auto it = std::lower_bound(list.begin(), list.end(), lo); it != list.end() && *it < hi; ++it)
+                *it = movedTo(*it, first, last, to);
+            std::sort(list.begin(), list.end());
+        }
+    }
+
+    /**
+     * @brief shiftRows adds delta to every row from from on
+     */
+    static void shiftRows(RowIndex& rows, int from, int delta){
+        for(auto it = rows.begin(); it != rows.end(); ++it){
+            QVector<int>& list = it.value();
+            for(auto row = std::lower_bound(list.begin(), list.end(), from); row != list.end(); ++row)
+                *row += delta;
+        }
+    }
+
+    static void indexRow(RowIndex& rows, const QString& key, int row){
+        QVector<int>& list = rows[key];
+        list.insert(std::lower_bound(list.begin(), list.end(), row), row);
+    }
+
+    static void unindexRow(RowIndex& rows, const QString& key, int row){
+        auto it = rows.find(key);
+        if(it == rows.end())
+            return;
+        QVector<int>& list = it.value();
+        const auto found = std::lower_bound(list.begin(), list.end(), row);
+        if(found != list.end() && *found == row)
+            list.erase(found);
+        if(list.isEmpty())
+            rows.erase(it);
+    }
+
+    /**
+     * @brief firstRightRow
+     * @param key
+     * @return The right row joined for key, -1 if none
+     */
+    inline int firstRightRow(const QString& key) const {
+        const auto it = mRightRows.constFind(key);
+        return it == mRightRows.constEnd() ? -1 : it.value().first();
+    }
+
+    /**
+     * @brief notifyKeys emits dataChanged for the joined rows of the keys
+     * @param keys
+     * @param rightRoles Changed right roles, empty for all
+     */
+    void notifyKeys(const QSet<QString>& keys, const QVector<int>& rightRoles){
+        QVector<int> roles;
+        if(!rightRoles.isEmpty()){
+            for(int r : rightRoles)
+                roles.append(RightRoleOffset + r);
+            roles.append(JoinedRole);
+        }
+        for(const QString& key : keys){
+            const auto it = mLeftRows.constFind(key);
+            if(it == mLeftRows.constEnd())
+                continue;
+            for(int row : it.value())
+                emit dataChanged(index(row), index(row), roles);
+        }
+    }
+
+    void onLeftRowsInserted(const QModelIndex& parent, int first, int last){
+        if(parent.isValid())
+            return;
+        mLeftKeys.insert(first, last - first + 1, QString());
+        for(int i = first; i <= last; ++i)
+            mLeftKeys[i] = leftKeyOf(i);
+        insertRows(mLeftRows, mLeftKeys, first, last);
+        endInsertRows();
+    }
+
+    void onLeftRowsRemoved(const QModelIndex& parent, int first, int last){
+        if(parent.isValid())
+            return;
+        removeRows(mLeftRows, mLeftKeys, first, last);
+        mLeftKeys.remove(first, last - first + 1);
+        endRemoveRows();
+    }
+
+    void onLeftRowsMoved(const QModelIndex& parent, int first, int last, const QModelIndex&, int to){
+        if(parent.isValid())
+            return;
+        /**
+          * to is the destination counted before the move
+          */
+        moveRows(mLeftRows, mLeftKeys, first, last, to);
+        if(to > last)
+            std::rotate(mLeftKeys.begin() + first, mLeftKeys.begin() + last + 1, mLeftKeys.begin() + to);
+        else
+            std::rotate(mLeftKeys.begin() + to, mLeftKeys.begin() + first, mLeftKeys.begin() + last + 1);
+        endMoveRows();
+    }
+
+    void onLeftDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles){
+        if(bottomRight.row() < topLeft.row())
+            return;
+        const bool keyChanged = mLeftRole >= 0 && (roles.isEmpty() || roles.contains(mLeftRole));
+        if(!keyChanged){
+            emit dataChanged(index(topLeft.row()), index(bottomRight.row()), roles);
+            return;
+        }
+        /**
+          * A row whose key changed joins another right row, all its roles change.
+          * Consecutive rows of the same kind are notified as one range
+          */
+        int first = topLeft.row();
+        bool rejoined = false;
+        for(int i = topLeft.row(); i <= bottomRight.row(); ++i){
+            const QString& key = leftKeyOf(i);
+            const bool changed = key != mLeftKeys.at(i);
+            if(changed){
+                unindexRow(mLeftRows, mLeftKeys.at(i), i);
+                indexRow(mLeftRows, key, i);
+                mLeftKeys[i] = key;
+            }
+            if(i > first && changed != rejoined){
+                emit dataChanged(index(first), index(i - 1), rejoined ? QVector<int>() : roles);
+                first = i;
+            }
+            rejoined = changed;
+        }
+        emit dataChanged(index(first), index(bottomRight.row()), rejoined ? QVector<int>() : roles);
+    }
+
+    void onRightRowsInserted(const QModelIndex& parent, int first, int last){
+        if(parent.isValid() || mRightRole < 0)
+            return;
+        QSet<QString> keys;
+        mRightKeys.insert(first, last - first + 1, QString());
+        for(int i = first; i <= last; ++i){
+            mRightKeys[i] = rightKeyOf(i);
+            keys.insert(mRightKeys.at(i));
+        }
+        insertRows(mRightRows, mRightKeys, first, last);
+        notifyKeys(keys, QVector<int>());
+    }
+
+    void onRightRowsRemoved(const QModelIndex& parent, int first, int last){
+        if(parent.isValid() || mRightRole < 0)
+            return;
+        QSet<QString> keys;
+        for(int i = first; i <= last; ++i)
+            keys.insert(mRightKeys.at(i));
+        removeRows(mRightRows, mRightKeys, first, last);
+        mRightKeys.remove(first, last - first + 1);
+        notifyKeys(keys, QVector<int>());
+    }
+
+    void onRightRowsMoved(const QModelIndex& parent, int first, int last, const QModelIndex&, int to){
+        if(parent.isValid() || mRightRole < 0)
+            return;
+        /**
+          * Moving duplicates may change which right row is first for a key
+          */
+        QHash<QString, int> previous;
+        for(int i = qMin(first, to); i < qMax(last + 1, to); ++i){
+            if(!previous.contains(mRightKeys.at(i)))
+                previous.insert(mRightKeys.at(i), firstRightRow(mRightKeys.at(i)));
+        }
+        moveRows(mRightRows, mRightKeys, first, last, to);
+        if(to > last)
+            std::rotate(mRightKeys.begin() + first, mRightKeys.begin() + last + 1, mRightKeys.begin() + to);
+        else
+            std::rotate(mRightKeys.begin() + to, mRightKeys.begin() + first, mRightKeys.begin() + last + 1);
+        QSet<QString> keys;
+        for(auto it = previous.constBegin(); it != previous.constEnd(); ++it){
+            /**
+              * The same right row moved keeps its values
+              */
+            if(movedTo(it.value(), first, last, to) != firstRightRow(it.key()))
+                keys.insert(it.key());
+        }
+        notifyKeys(keys, QVector<int>());
+    }
+
+    static inline int movedTo(int row, int first, int last, int to){
+        const int count = last - first + 1;
+        if(row >= first && row <= last)
+            return to > last ? row + to - last - 1 : row - first + to;
+        if(to > last && row > last && row < to)
+            return row - count;
+        if(to < first && row >= to && row < first)
+            return row + count;
+        return row;
+    }
+
+    void onRightDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles){
+        if(mRightRole < 0)
+            return;
+        const bool keyChanged = roles.isEmpty() || roles.contains(mRightRole);
+        QSet<QString> keys, moved;
+        for(int i = topLeft.row(); i <= bottomRight.row(); ++i){
+            if(keyChanged){
+                const QString& key = rightKeyOf(i);
+                if(key != mRightKeys.at(i)){
+                    moved.insert(mRightKeys.at(i));
+                    moved.insert(key);
+                    unindexRow(mRightRows, mRightKeys.at(i), i);
+                    indexRow(mRightRows, key, i);
+                    mRightKeys[i] = key;
+                    continue;
+                }
+            }
+            /**
+              * Only the first right row of a key is joined
+              */
+            if(firstRightRow(mRightKeys.at(i)) == i)
+                keys.insert(mRightKeys.at(i));
+        }
+        notifyKeys(moved, QVector<int>());
+        keys.subtract(moved);
+        notifyKeys(keys, roles);
+    }
+
+    QAbstractItemModel*             mLeft;
+    QAbstractItemModel*             mRight;
+    QString                         mLeftKeyName;
+    QString                         mRightKeyName;
+    QString                         mRightPrefix;
+    int                             mLeftRole;
+    int                             mRightRole;
+    QVector<QString>                mLeftKeys;
+    QVector<QString>                mRightKeys;
+    RowIndex                        mLeftRows;
+    RowIndex                        mRightRows;
+    QHash<int, QByteArray>          mRoleNames;
+};
+
+#endif // QMLLISTJOINMODEL_H
@@ -4,16 +4,40 @@
 /**
   * Enable or Disable Serialize
   */
+#ifndef UsingSerialize
 #define UsingSerialize  0
+#endif
 
 /**
   * Enable or Disable Json
   */
+#ifndef UsingJson
 #define UsingJson       0
+#endif
+
+/**
+  * Enable or Disable runtime statistics and tracing
+  */
+#ifndef UsingStats
+#define UsingStats      0
+#endif
 
 #include <QAbstractListModel>
 #include <QMetaProperty>
 #include <QQmlEngine>
+#include <QJSValue>
+#include <QBitArray>
+#include <QTimer>
+#include <QPointer>
+#include <QSet>
+#include <QMap>
+#include <QThread>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QRunnable>
+#include <algorithm>
+#include <iterator>
+#include <functional>
 #if UsingJson
     #include <QJsonDocument>
     #include <QJsonObject>
@@ -21,53 +45,2816 @@
 #endif
 #if UsingSerialize
     #include <QDataStream>
+    #include <QtEndian>
+#endif
+#if UsingStats
+    #include <QElapsedTimer>
+    #include <QMutex>
+    #include <QFile>
+    #include <QJsonDocument>
+    #include <QJsonObject>
+    #include <QJsonArray>
+    #include <QCoreApplication>
 #endif
 #include <QDebug>
 
 /**
- * @brief The QAbstractBase class
- * TBD
+ * @brief The QmlListModelParallel class runs indexed tasks on a bounded thread pool
  */
-class QAbstractBase : public QAbstractListModel
+class QmlListModelParallel
+{
+public:
+    /**
+     * @brief run blocks until f(0) ... f(tasks - 1) have finished
+     * @param tasks
+     * @param threads Maximum worker threads, 1 runs on the calling thread
+     * @param f
+     */
+    static inline void run(int tasks, int threads, const std::function<void(int)>& f){
+        if(threads <= 1 || tasks <= 1){
+            for(int i = 0; i < tasks; ++i)
+                f(i);
+            return;
+        }
+        QThreadPool pool;
+        pool.setMaxThreadCount(qMin(threads, tasks));
+        for(int i = 0; i < tasks; ++i)
+            pool.start(new Task(f, i));
+        pool.waitForDone();
+    }
+
+private:
+    class Task : public QRunnable
+    {
+    public:
+        Task(const std::function<void(int)>& f, int i):
+            mF(f), mI(i){}
+        void run() override {
+            mF(mI);
+        }
+    private:
+        const std::function<void(int)>& mF;
+        int mI;
+    };
+};
+
+#if UsingJson
+/**
+ * @brief qmlListPropertyToJson converts a property value to Json
+ * @param type QVariant::Type of the property
+ * @param v
+ * @param ok
+ * @return
+ */
+inline QJsonValue qmlListPropertyToJson(int type, const QVariant& v, bool* ok)
+{
+    *ok = true;
+    switch (type) {
+    case QVariant::Bool:
+        return QJsonValue(v.toBool());
+    case QVariant::Double:
+        return QJsonValue(v.toDouble());
+    case QVariant::UInt:
+    case QVariant::Int:
+        return QJsonValue(v.toInt());
+    case QVariant::Char:
+    case QVariant::String:
+        return QJsonValue(v.toString());
+    default:
+        *ok = false;
+        return QJsonValue();
+    }
+}
+#endif
+
+/**
+ * @brief The QmlListModelObserver class is notified of the row mutations of a model.
+ * The notifications are sent before the views receive the model signals,
+ * so snapshots and indexes are always current when bindings are evaluated.
+ */
+class QmlListModelObserver
+{
+public:
+    virtual ~QmlListModelObserver(){}
+
+    virtual void rowsInserted(int first, int last){
+        Q_UNUSED(first);
+        Q_UNUSED(last);
+    }
+
+    virtual void rowsAboutToBeRemoved(int first, int last){
+        Q_UNUSED(first);
+        Q_UNUSED(last);
+    }
+
+    virtual void rowsRemoved(int first, int last){
+        Q_UNUSED(first);
+        Q_UNUSED(last);
+    }
+
+    virtual void rowsAboutToChange(int first, int last, const QVector<int>& roles){
+        Q_UNUSED(first);
+        Q_UNUSED(last);
+        Q_UNUSED(roles);
+    }
+
+    virtual void rowsChanged(int first, int last, const QVector<int>& roles){
+        Q_UNUSED(first);
+        Q_UNUSED(last);
+        Q_UNUSED(roles);
+    }
+
+    /**
+     * @brief rowsMoved
+     * @param first First moved row before the move
+     * @param last Last moved row before the move
+     * @param to Index of the first moved row after the move
+     */
+    virtual void rowsMoved(int first, int last, int to){
+        Q_UNUSED(first);
+        Q_UNUSED(last);
+        Q_UNUSED(to);
+    }
+};
+
+/**
+ * @brief The QmlListModelSnapshot class is an immutable view of the rows of a model.
+ * It shares the row records with the model by implicit sharing, so it is cheap to take
+ * and safe to read from any thread while the model keeps changing.
+ * Nested list models are captured as nested snapshots.
+ */
+class QmlListModelSnapshot
 {
 public:
-    explicit QAbstractBase(QObject *parent = 0):
-    QAbstractListModel(parent){}
+    /**
+     * @brief Row record, the property values in property order
+     */
+    struct Row {
+        const QObject*      object;
+        QVector<QVariant>   values;
+    };
+
+    /**
+     * @brief Rows in chunks, ends[k] is the count of rows up to and including chunk k
+     */
+    struct Rope {
+        QVector<QVector<Row> >  chunks;
+        QVector<int>            ends;
+    };
+
+    QmlListModelSnapshot():
+        mOffset(0){}
+
+    QmlListModelSnapshot(const QVector<QByteArray>& names, const QVector<int>& types, int offset, const Rope& rope):
+        mNames(names), mTypes(types), mOffset(offset), mRope(rope){}
+
+    inline int size() const {
+        return mRope.ends.isEmpty() ? 0 : mRope.ends.last();
+    }
+
+    inline bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief object
+     * @param i
+     * @return The identity of the row object, it must not be dereferenced from other threads
+     */
+    inline const QObject* object(int i) const {
+        const Row* r = rowAt(i);
+        return r == Q_NULLPTR ? Q_NULLPTR : r->object;
+    }
+
+    /**
+     * @brief row
+     * @param i
+     * @return Property values of row i in property order
+     */
+    inline QVector<QVariant> row(int i) const {
+        const Row* r = rowAt(i);
+        return r == Q_NULLPTR ? QVector<QVariant>() : r->values;
+    }
+
+    /**
+     * @brief value
+     * @param i
+     * @param role Same role as the model's roleNames()
+     * @return
+     */
+    inline QVariant value(int i, int role) const {
+        const Row* r = rowAt(i);
+        if(r == Q_NULLPTR || role < mOffset || role - mOffset >= r->values.size())
+            return QVariant();
+        return r->values.at(role - mOffset);
+    }
+
+    inline QVariant value(int i, const QByteArray& roleName) const {
+        const int p = mNames.indexOf(roleName);
+        return p < 0 ? QVariant() : value(i, p + mOffset);
+    }
+
+    inline QHash<int, QByteArray> roleNames() const {
+        QHash<int, QByteArray> roles;
+        for(int i = 0; i < mNames.size(); ++i)
+            roles[i + mOffset] = mNames.at(i);
+        return roles;
+    }
+
+    inline const QVector<QByteArray>& names() const {
+        return mNames;
+    }
+
+    /**
+     * @brief types
+     * @return QVariant::Type of each property
+     */
+    inline const QVector<int>& types() const {
+        return mTypes;
+    }
+
+    inline int roleOffset() const {
+        return mOffset;
+    }
+
+    inline const Rope& rope() const {
+        return mRope;
+    }
 
 #if UsingSerialize
-    virtual void fromBytes(QDataStream& s){
-        Q_UNUSED(s);
+    /**
+     * @brief toBytes writes the same bytes as QmlListModel::toBytes,
+     * the chunks of rows are serialized concurrently and written in order.
+     * @param s
+     * @param threads
+     */
+    inline void toBytes(QDataStream& s, int threads = 1) const {
+        s << quint32(size());
+        if(threads <= 1){
+            for(const QVector<Row>& chunk : mRope.chunks)
+                writeRows(s, chunk);
+            return;
+        }
+        QVector<QByteArray> parts(mRope.chunks.size());
+        const int version = s.version();
+        const QDataStream::ByteOrder byteOrder = s.byteOrder();
+        const QDataStream::FloatingPointPrecision precision = s.floatingPointPrecision();
+        QmlListModelParallel::run(parts.size(), threads, [&](int k){
+            QDataStream part(&parts[k], QIODevice::WriteOnly);
+            part.setVersion(version);
+            part.setByteOrder(byteOrder);
+            part.setFloatingPointPrecision(precision);
+            writeRows(part, mRope.chunks.at(k));
+        });
+        for(const QByteArray& part : parts)
+            s.writeRawData(part.constData(), part.size());
     }
 
-    virtual void toBytes(QDataStream& s){
-        Q_UNUSED(s);
+    /**
+     * @brief toBytesFramed writes the rows in length-prefixed chunks,
+     * which QmlListModel::fromBytesFramed decodes concurrently.
+     * Format: magic, row count, chunk count, (rows, bytes) per chunk, then the chunk payloads
+     * in the toBytes row encoding.
+     * @param s
+     * @param threads
+     */
+    inline void toBytesFramed(QDataStream& s, int threads = 1) const {
+        QVector<QByteArray> parts(mRope.chunks.size());
+        const int version = s.version();
+        const QDataStream::ByteOrder byteOrder = s.byteOrder();
+        const QDataStream::FloatingPointPrecision precision = s.floatingPointPrecision();
+        QmlListModelParallel::run(parts.size(), threads, [&](int k){
+            QDataStream part(&parts[k], QIODevice::WriteOnly);
+            part.setVersion(version);
+            part.setByteOrder(byteOrder);
+            part.setFloatingPointPrecision(precision);
+            writeRows(part, mRope.chunks.at(k));
+        });
+        s << quint32(FramedMagic) << quint32(size()) << quint32(parts.size());
+        for(int k = 0; k < parts.size(); ++k)
+            s << quint32(mRope.chunks.at(k).size()) << quint32(parts.at(k).size());
+        for(const QByteArray& part : parts)
+            s.writeRawData(part.constData(), part.size());
     }
 
-    virtual QByteArray serialize(){
-        return QByteArray();
+    /**
+     * @brief Magic number of the framed format, "QLMF"
+     */
+    static const quint32 FramedMagic = 0x514C4D46;
+#endif
+
+#if UsingJson
+    /**
+     * @brief toJson converts the chunks of rows concurrently
+     * @param threads
+     * @return The same array as QmlListModel::toJson
+     */
+    inline QJsonArray toJson(int threads = 1) const {
+        QVector<QJsonArray> parts(mRope.chunks.size());
+        QmlListModelParallel::run(parts.size(), threads, [&](int k){
+            for(const Row& r : mRope.chunks.at(k))
+                parts[k].append(rowToJson(r));
+        });
+        QJsonArray jsonArray;
+        for(const QJsonArray& part : parts){
+            for(const QJsonValue& v : part)
+                jsonArray.append(v);
+        }
+        return jsonArray;
+    }
+
+    /**
+     * @brief toJsonCompact converts and encodes the chunks of rows concurrently
+     * @param threads
+     * @return The same bytes as QJsonDocument(toJson()).toJson(QJsonDocument::Compact)
+     */
+    inline QByteArray toJsonCompact(int threads = 1) const {
+        QVector<QByteArray> parts(mRope.chunks.size());
+        QmlListModelParallel::run(parts.size(), threads, [&](int k){
+            for(const Row& r : mRope.chunks.at(k)){
+                if(!parts[k].isEmpty())
+                    parts[k].append(',');
+                parts[k].append(QJsonDocument(rowToJson(r)).toJson(QJsonDocument::Compact));
+            }
+        });
+        QByteArray json("[");
+        for(int k = 0; k < parts.size(); ++k){
+            if(k > 0)
+                json.append(',');
+            json.append(parts.at(k));
+        }
+        json.append(']');
+        return json;
+    }
+#endif
+
+#if UsingSerialize
+    /**
+     * @brief writeRows writes rows, e.g. one chunk of rope(), in the toBytes row encoding
+     * @param s
+     * @param rows
+     */
+    inline void writeRows(QDataStream& s, const QVector<Row>& rows) const;
+#endif
+
+#if UsingJson
+    /**
+     * @brief rowToJson
+     * @param r
+     * @return The Json object of one row, as in toJson
+     */
+    inline QJsonObject rowToJson(const Row& r) const;
+#endif
+
+private:
+    inline const Row* rowAt(int i) const {
+        if(i < 0 || i >= size())
+            return Q_NULLPTR;
+        const int k = int(std::upper_bound(mRope.ends.constBegin(), mRope.ends.constEnd(), i) - mRope.ends.constBegin());
+        return &mRope.chunks.at(k).at(i - (k == 0 ? 0 : mRope.ends.at(k - 1)));
+    }
+
+    QVector<QByteArray> mNames;
+    QVector<int>        mTypes;
+    int                 mOffset;
+    Rope                mRope;
+};
+Q_DECLARE_METATYPE(QmlListModelSnapshot)
+
+#if UsingSerialize
+inline void QmlListModelSnapshot::writeRows(QDataStream& s, const QVector<Row>& rows) const
+{
+    const int nested = qMetaTypeId<QmlListModelSnapshot>();
+    for(const Row& r : rows){
+        for(int j = 0; j < r.values.size(); ++j){
+            if(mTypes.at(j) == nested){
+                /**
+                  * A null nested model is written as an empty one
+                  */
+                const QmlListModelSnapshot& subList = r.values.at(j).value<QmlListModelSnapshot>();
+                subList.toBytes(s);
+            } else {
+                s << r.values.at(j);
+            }
+        }
+    }
+}
+#endif
+
+#if UsingJson
+inline QJsonObject QmlListModelSnapshot::rowToJson(const Row& r) const
+{
+    const int nested = qMetaTypeId<QmlListModelSnapshot>();
+    QJsonObject jsonObj;
+    for(int j = 0; j < r.values.size(); ++j){
+        const QVariant& v = r.values.at(j);
+        if(mTypes.at(j) == nested){
+            if(v.isValid())
+                jsonObj.insert(mNames.at(j), v.value<QmlListModelSnapshot>().toJson());
+            else
+                jsonObj.insert(mNames.at(j), QJsonValue());
+        } else {
+            bool ok;
+            const QJsonValue& jsonValue = qmlListPropertyToJson(mTypes.at(j), v, &ok);
+            if(ok)
+                jsonObj.insert(mNames.at(j), jsonValue);
+            else
+                qDebug()<<"QmlListModelSnapshot"<<__FUNCTION__<<"Error: Wrong property."<<mNames.at(j)<<v;
+        }
+    }
+    return jsonObj;
+}
+#endif
+
+#if UsingStats
+/**
+ * @brief The QmlListModelTrace class collects Chrome trace events ("ph":"X") of all models,
+ * loadable by chrome://tracing or Perfetto.
+ * Define QML_LIST_MODEL_TRACEPOINT(name, model) before including this header
+ * to forward the same scopes to Q_TRACE or LTTng tracepoints.
+ */
+class QmlListModelTrace
+{
+public:
+    /**
+     * @brief start collects the events until stop()
+     * @param fileName
+     */
+    static inline void start(const QString& fileName){
+        QMutexLocker lock(&state().mutex);
+        state().fileName = fileName;
+        state().events = QJsonArray();
+        state().clock.start();
+        state().enabled.storeRelease(1);
+    }
+
+    /**
+     * @brief stop writes the collected events
+     * @return the result of writing
+     */
+    static inline bool stop(){
+        QMutexLocker lock(&state().mutex);
+        state().enabled.storeRelease(0);
+        QFile file(state().fileName);
+        if(!file.open(QIODevice::WriteOnly))
+            return false;
+        QJsonObject root;
+        root.insert("traceEvents", state().events);
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        state().events = QJsonArray();
+        return true;
+    }
+
+    static inline bool isEnabled(){
+        return state().enabled.loadAcquire();
+    }
+
+    static inline qint64 now(){
+        return state().clock.nsecsElapsed() / 1000;
+    }
+
+    static inline void complete(const char* name, const char* category, qint64 begin, qint64 duration){
+        QJsonObject event;
+        event.insert("name", QLatin1String(name));
+        event.insert("cat", QLatin1String(category));
+        event.insert("ph", QLatin1String("X"));
+        event.insert("ts", double(begin));
+        event.insert("dur", double(duration));
+        event.insert("pid", double(QCoreApplication::applicationPid()));
+        event.insert("tid", double(quintptr(QThread::currentThreadId())));
+        QMutexLocker lock(&state().mutex);
+        state().events.append(event);
+    }
+
+private:
+    struct State {
+        QMutex          mutex;
+        QAtomicInt      enabled;
+        QElapsedTimer   clock;
+        QString         fileName;
+        QJsonArray      events;
+    };
+
+    static inline State& state(){
+        static State s;
+        return s;
+    }
+};
+
+class QmlListModelStats;
+
+    #define QML_LIST_STATS(statement) statement
+    #define QML_LIST_MODEL_STATS \
+    Q_PROPERTY(QmlListModelStats* stats READ stats CONSTANT)
+#else
+    #define QML_LIST_STATS(statement)
+    #define QML_LIST_MODEL_STATS
+#endif
+
+class QmlListModelSnapshotTracker;
+class QmlListModelPatchRecorder;
+class QmlListViewportCache;
+class QmlListStringInterner;
+class QmlListAggregate;
+class QAbstractBase;
+
+/**
+ * @brief The QmlListRowRegistry class counts the models holding a shared row.
+ * A row shared by shareData() is deleted when the last of its models removes it,
+ * and a change made through one model is notified by all of them.
+ * Only rows held by two models or more are registered, the registry is used from the GUI thread only.
+ */
+class QmlListRowRegistry
+{
+public:
+    static inline bool isEmpty(){
+        return rows().isEmpty();
+    }
+
+    static inline bool contains(const QObject* obj){
+        return rows().contains(obj);
+    }
+
+    /**
+     * @brief share records one more model holding obj
+     * @param obj
+     * @param model
+     */
+    static inline void share(const QObject* obj, QAbstractBase* model){
+        rows()[obj].append(model);
+    }
+
+    /**
+     * @brief release records one model less holding obj
+     * @param obj
+     * @param model
+     * @return Whether the row is no longer shared, the remaining model then owns it alone
+     */
+    static inline bool release(const QObject* obj, QAbstractBase* model){
+        auto it = rows().find(obj);
+        if(it == rows().end())
+            return true;
+        it->removeOne(model);
+        if(it->size() > 1)
+            return false;
+        const bool held = !it->isEmpty();
+        rows().erase(it);
+        return !held;
+    }
+
+    static inline QVector<QAbstractBase*> models(const QObject* obj){
+        return rows().value(obj);
+    }
+
+    /**
+     * @brief The FanOut class marks the notifications sent to the other models of a row,
+     * which are not sent on again
+     */
+    class FanOut
+    {
+    public:
+        inline FanOut(){ ++depth(); }
+        inline ~FanOut(){ --depth(); }
+        static inline bool isActive(){ return depth() > 0; }
+    private:
+        static inline int& depth(){
+            static int d = 0;
+            return d;
+        }
+    };
+
+private:
+    static inline QHash<const QObject*, QVector<QAbstractBase*> >& rows(){
+        static QHash<const QObject*, QVector<QAbstractBase*> > r;
+        return r;
+    }
+};
+
+/**
+ * @brief The QmlListMemoryUsage struct is the heap used by a model in bytes, by category.
+ * The sizes are estimated from the Qt containers headers and capacities,
+ * allocator overhead and data shared between rows are not taken into account.
+ */
+struct QmlListMemoryUsage
+{
+    /**
+      * The pointer array of the rows
+      */
+    qint64 storage          = 0;
+    /**
+      * The row objects, sizeof(T) plus the QObject private data
+      */
+    qint64 objects          = 0;
+    /**
+      * The heap payload of the properties, QString, QByteArray and lists
+      */
+    qint64 payload          = 0;
+    /**
+      * The nested list models, recursively
+      */
+    qint64 nested           = 0;
+    /**
+      * The string pools of the interned roles, counted once instead of in payload
+      */
+    qint64 interned         = 0;
+    /**
+      * The removed rows waiting for deleteLater
+      */
+    qint64 pendingDeletes   = 0;
+    int    rows             = 0;
+    int    sampledRows      = 0;
+
+    inline qint64 total() const {
+        return storage + objects + payload + nested + interned + pendingDeletes;
+    }
+
+    inline QVariantMap toVariantMap() const {
+        QVariantMap map;
+        map.insert("storage", storage);
+        map.insert("objects", objects);
+        map.insert("payload", payload);
+        map.insert("nested", nested);
+        map.insert("interned", interned);
+        map.insert("pendingDeletes", pendingDeletes);
+        map.insert("total", total());
+        map.insert("rows", rows);
+        map.insert("sampledRows", sampledRows);
+        return map;
+    }
+
+    /**
+      * Estimated size of QObjectPrivate on 64 bit Qt 5
+      */
+    static const int ObjectPrivateBytes = 136;
+
+    /**
+     * @brief valueBytes
+     * @param v
+     * @return The heap bytes held by a property value, beyond the value itself
+     */
+    static inline qint64 valueBytes(const QVariant& v){
+        switch(int(v.type())){
+        case QMetaType::QString: {
+            const QString& str = v.toString();
+            return str.isNull() ? 0 : qint64(sizeof(QArrayData)) + (str.capacity() + 1) * qint64(sizeof(QChar));
+        }
+        case QMetaType::QByteArray: {
+            const QByteArray& bytes = v.toByteArray();
+            return bytes.isNull() ? 0 : qint64(sizeof(QArrayData)) + bytes.capacity() + 1;
+        }
+        case QMetaType::QStringList: {
+            const QStringList& list = v.toStringList();
+            qint64 bytes = list.isEmpty() ? 0 : qint64(sizeof(QListData::Data)) + list.size() * qint64(sizeof(void*));
+            for(const QString& str : list)
+                bytes += valueBytes(str);
+            return bytes;
+        }
+        case QMetaType::QVariantList: {
+            const QVariantList& list = v.toList();
+            qint64 bytes = list.isEmpty() ? 0 : qint64(sizeof(QListData::Data)) + list.size() * qint64(sizeof(void*) + sizeof(QVariant));
+            for(const QVariant& value : list)
+                bytes += valueBytes(value);
+            return bytes;
+        }
+        case QMetaType::QVariantMap: {
+            const QVariantMap& map = v.toMap();
+            qint64 bytes = 0;
+            for(auto it = map.constBegin(); it != map.constEnd(); ++it)
+                bytes += 3 * qint64(sizeof(void*)) + qint64(sizeof(QString) + sizeof(QVariant)) + valueBytes(it.key()) + valueBytes(it.value());
+            return bytes;
+        }
+        default:
+            return 0;
+        }
+    }
+};
+
+/**
+ * @brief The QmlListStringPool class keeps one copy of each distinct string,
+ * the interned values share its data instead of holding their own.
+ */
+class QmlListStringPool
+{
+public:
+    /**
+     * @brief intern
+     * @param str
+     * @return The pooled string equal to str, sharing the data of every other equal value.
+     * A new value is pooled as a copy of its own, str may be a QString::fromRawData view.
+     */
+    inline QString intern(const QString& str){
+        auto it = mStrings.constFind(str);
+        if(it != mStrings.constEnd())
+            return *it;
+        const QString pooled(str.constData(), str.size());
+        mStrings.insert(pooled);
+        return pooled;
+    }
+
+    inline int size() const {
+        return mStrings.size();
+    }
+
+    /**
+     * @brief bytes
+     * @return The heap of the pooled strings and of the hash
+     */
+    inline qint64 bytes() const {
+        qint64 b = qint64(mStrings.capacity()) * qint64(sizeof(void*) * 3 + sizeof(QString));
+        for(const QString& str : mStrings)
+            b += QmlListMemoryUsage::valueBytes(str);
+        return b;
+    }
+
+    /**
+     * @brief squeeze drops the strings no row refers to any more
+     * @return The strings dropped
+     */
+    inline int squeeze(){
+        int dropped = 0;
+        for(auto it = mStrings.begin(); it != mStrings.end();){
+            if(it->isDetached()){
+                it = mStrings.erase(it);
+                ++dropped;
+            } else {
+                ++it;
+            }
+        }
+        return dropped;
+    }
+
+private:
+    QSet<QString> mStrings;
+};
+
+/**
+ * @brief The QAbstractBase class
+ * TBD
+ */
+class QAbstractBase : public QAbstractListModel
+{
+public:
+    explicit inline QAbstractBase(QObject *parent = 0);
+
+    inline ~QAbstractBase();
+
+#if UsingStats
+    /**
+     * @brief stats
+     * @return The activity counters of this model
+     */
+    inline QmlListModelStats* stats() const {
+        return mStats;
+    }
+#endif
+
+    /**
+     * @brief rowObject
+     * @param i
+     * @return The row object, or null when out of range
+     */
+    virtual QObject* rowObject(int i) const {
+        Q_UNUSED(i);
+        return Q_NULLPTR;
+    }
+
+    /**
+     * @brief rowIndex
+     * @param obj
+     * @return The row of obj, or -1
+     */
+    virtual int rowIndex(const QObject* obj) const {
+        Q_UNUSED(obj);
+        return -1;
+    }
+
+    /**
+     * @brief rowMetaObject
+     * @return The meta object of the row type
+     */
+    virtual const QMetaObject* rowMetaObject() const {
+        return Q_NULLPTR;
+    }
+
+    /**
+     * @brief rowSize
+     * @return sizeof the row type
+     */
+    virtual int rowSize() const {
+        return 0;
+    }
+
+    /**
+     * @brief newRow
+     * @return A new default constructed row, owned by the caller
+     */
+    virtual QObject* newRow() const {
+        return Q_NULLPTR;
+    }
+
+    /**
+     * @brief appendRows appends rows made by newRow() by one insertion
+     * @param rows
+     */
+    virtual void appendRows(const QList<QObject*>& rows){
+        Q_UNUSED(rows);
+    }
+
+    /**
+     * @brief Fetcher returns at most count rows made by newRow(), following the from rows already fetched.
+     * Fewer rows than count end the fetching.
+     */
+    typedef std::function<QList<QObject*>(int from, int count)> Fetcher;
+
+    /**
+     * @brief setFetcher loads the rows lazily, a page whenever a view asks for more by fetchMore()
+     * @param fetcher
+     * @param pageSize
+     */
+    inline void setFetcher(const Fetcher& fetcher, int pageSize = 256){
+        mFetcher = fetcher;
+        mFetchPageSize = pageSize;
+        mFetchDone = !fetcher;
+    }
+
+    /**
+     * @brief isFetching
+     * @return Whether the rows being inserted come from the fetcher
+     */
+    inline bool isFetching() const {
+        return mFetching;
+    }
+
+    bool canFetchMore(const QModelIndex &parent) const override {
+        return !parent.isValid() && !mFetchDone;
+    }
+
+    void fetchMore(const QModelIndex &parent) override {
+        if(parent.isValid() || mFetchDone || mFetching)
+            return;
+        const QList<QObject*>& rows = mFetcher(rowCount(QModelIndex()), mFetchPageSize);
+        if(rows.size() < mFetchPageSize)
+            mFetchDone = true;
+        mFetching = true;
+        appendRows(rows);
+        mFetching = false;
+    }
+
+    /**
+     * @brief setViewport tells the model the rows a view shows and the roles its delegate binds.
+     * Those roles of the visible rows and of as many rows ahead on each side are read into
+     * a hot cache which data() serves on the model thread, and the next fetcher page is
+     * requested once the rows ahead reach the end.
+     * The cache follows the changes made through the model API, and the rows of every dataChanged
+     * of the model, so a row written directly is refreshed once dataChanged is emitted for it.
+     * @param first
+     * @param last
+     * @param roles Role names, empty for all
+     */
+    inline void setViewport_(int first, int last, const QStringList& roles);
+
+    /**
+     * @brief clearViewport drops the hot cache and its hit counts
+     */
+    inline void clearViewport();
+
+    /**
+     * @brief setInternedRoles keeps one copy of each distinct value of these QString roles.
+     * The existing rows and the rows later inserted or changed through the model API,
+     * including fromJson, fromBytes and applyPatch, share the string data of equal values.
+     * @param roles Role names, empty to stop interning
+     */
+    inline void setInternedRoles(const QStringList& roles);
+
+    inline QStringList internedRoles() const;
+
+    /**
+     * @brief stringPool
+     * @param role
+     * @return The pool of an interned role, null if the role is not interned
+     */
+    inline const QmlListStringPool* stringPool(const QString& role) const;
+
+    /**
+     * @brief squeezeStringPools drops the pooled strings of the deleted rows
+     * @return The strings dropped
+     */
+    inline int squeezeStringPools();
+
+    /**
+     * @brief viewportHits
+     * @return The data() calls served by the hot cache
+     */
+    inline quint64 viewportHits() const;
+
+    /**
+     * @brief viewportMisses
+     * @return The data() calls read from the rows while a viewport is set
+     */
+    inline quint64 viewportMisses() const;
+
+    inline double viewportHitRatio() const {
+        const quint64 calls = viewportHits() + viewportMisses();
+        return calls == 0 ? 0 : double(viewportHits()) / calls;
+    }
+
+    /**
+     * @brief snapshot must be called from the model thread,
+     * the snapshot itself can be read from any thread.
+     * Without snapshot tracking every call reads all the rows, O(n), and nothing is kept.
+     * With it, the calls are O(1) plus the rows changed since the last one.
+     * @return Immutable view of the rows
+     */
+    inline QmlListModelSnapshot snapshot();
+
+    /**
+     * @brief setSnapshotTracking keeps the row records of the snapshots up to date as the model changes.
+     * The tracker holds a QVariant of every property of every row, about the payload of the rows again,
+     * and reads the rows touched by each change; starting it reads all the rows once.
+     * Nested list models are read whole at each record unless they track too.
+     * Property writes which bypass the model API are not tracked, a tracked snapshot keeps the old value.
+     * @param tracking
+     */
+    inline void setSnapshotTracking(bool tracking);
+
+    inline bool isSnapshotTracking() const {
+        return mSnapshotTracker != Q_NULLPTR;
+    }
+
+    inline void addObserver(QmlListModelObserver* observer){
+        if(!mObservers.contains(observer))
+            mObservers.append(observer);
+    }
+
+    inline void removeObserver(QmlListModelObserver* observer){
+        mObservers.removeAll(observer);
+    }
+
+    /**
+     * @brief isSubList
+     * @param p
+     * @return Whether the property holds a nested list model pointer
+     */
+    static inline bool isSubList(const QMetaProperty& p){
+        const char* name = p.typeName();
+        const int l = name == Q_NULLPTR ? 0 : qstrlen(name);
+        return l > 0 && name[l - 1] == '*';
+    }
+
+    /**
+     * @brief subList
+     * @param p
+     * @param obj
+     * @return The nested list model held by the property of obj, or null
+     */
+    static inline QAbstractBase* subList(const QMetaProperty& p, const QObject* obj){
+        if(!isSubList(p))
+            return Q_NULLPTR;
+        return dynamic_cast<QAbstractBase*>(qvariant_cast<QObject *>(p.read(obj)));
+    }
+
+    /**
+     * @brief moveRowToThread moves a row, its nested list models and their rows to thread
+     * @param obj
+     * @param thread
+     */
+    static inline void moveRowToThread(QObject* obj, QThread* thread){
+        if(obj == Q_NULLPTR)
+            return;
+        obj->moveToThread(thread);
+        const QMetaObject* metaData = obj->metaObject();
+        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j) {
+            QAbstractBase* list = subList(metaData->property(j), obj);
+            if(list != Q_NULLPTR){
+                list->moveToThread(thread);
+                for(int i = 0; i < list->rowCount(QModelIndex()); ++i)
+                    moveRowToThread(list->rowObject(i), thread);
+            }
+        }
+    }
+
+    /**
+     * @brief memoryUsage estimates the heap used by the rows, recursively through the nested list models.
+     * The payload of large models is extrapolated from evenly spaced rows, which keeps
+     * a sample of a 1M rows model in the order of a millisecond.
+     * @param sampleRows Rows read at most, 0 reads every row
+     * @return
+     */
+    inline QmlListMemoryUsage memoryUsage(int sampleRows = 1024) const;
+
+#if UsingSerialize
+    virtual void fromBytes(QDataStream& s){
+        Q_UNUSED(s);
+    }
+
+    virtual void toBytes(QDataStream& s){
+        Q_UNUSED(s);
+    }
+
+    virtual QByteArray serialize(){
+        return QByteArray();
+    }
+
+    virtual void unserialize(QByteArray data) {
+        Q_UNUSED(data);
+    }
+
+    virtual QByteArray toBytesSchema(){
+        return QByteArray();
+    }
+
+    virtual bool fromBytesSchema(const QByteArray& data, bool adoptStrings = false){
+        Q_UNUSED(data);
+        Q_UNUSED(adoptStrings);
+        return false;
+    }
+
+    /**
+     * @brief adoptsStrings
+     * @return Whether the rows may hold QString values adopted by fromBytesSchema
+     */
+    virtual bool adoptsStrings() const {
+        return false;
+    }
+
+    /**
+     * @brief detachStrings gives the QString properties of a row and of its nested rows
+     * their own copy of the data
+     * @param obj
+     */
+    static inline void detachStrings(QObject* obj){
+        const QMetaObject* metaData = obj->metaObject();
+        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j){
+            const QMetaProperty& p = metaData->property(j);
+            if(isSubList(p)){
+                QAbstractBase* list = subList(p, obj);
+                for(int i = 0; list != Q_NULLPTR && i < list->rowCount(QModelIndex()); ++i)
+                    detachStrings(list->rowObject(i));
+            } else if(p.userType() == QMetaType::QString){
+                const QString& v = p.read(obj).toString();
+                if(!v.isEmpty())
+                    p.write(obj, QString(v.constData(), v.size()));
+            }
+        }
+    }
+
+    /**
+     * @brief writeRow writes the properties of one row in the toBytes encoding
+     * @param s
+     * @param obj
+     */
+    static inline void writeRow(QDataStream& s, const QObject* obj){
+        const QMetaObject* metaData = obj->metaObject();
+        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j)
+            writeProperty(s, metaData->property(j), obj);
+    }
+
+    /**
+     * @brief writeProperty writes one property in the toBytes encoding, a nested list model as its toBytes
+     * @param s
+     * @param p
+     * @param obj
+     */
+    static inline void writeProperty(QDataStream& s, const QMetaProperty& p, const QObject* obj){
+        if(isSubList(p)){
+            QAbstractBase* list = subList(p, obj);
+            if(list != Q_NULLPTR)
+                list->toBytes(s);
+            else
+                s << quint32(0);
+        } else {
+            s << p.read(obj);
+        }
+    }
+
+    /**
+     * @brief setPatchRecording starts or stops recording the changes made through the model API
+     * into a patch, which takePatch() returns and applyPatch() replays on a mirror of this model.
+     * @param recording
+     */
+    inline void setPatchRecording(bool recording);
+
+    inline bool isPatchRecording() const {
+        return mPatchRecorder != Q_NULLPTR;
+    }
+
+    /**
+     * @brief takePatch
+     * @return The changes recorded since the last call, from patchRevision() to patchRevision() + 1,
+     * or an empty array when nothing changed
+     */
+    inline QByteArray takePatch();
+
+    /**
+     * @brief patchRevision
+     * @return The revision of the last patch taken, or applied on a mirror
+     */
+    inline quint32 patchRevision() const {
+        return mPatchRevision;
+    }
+
+    /**
+     * @brief setPatchRevision aligns a mirror after a full copy, e.g. by unserialize(),
+     * with the patchRevision() of its source
+     * @param revision
+     */
+    inline void setPatchRevision(quint32 revision){
+        mPatchRevision = revision;
+    }
+
+    /**
+     * @brief Magic number of the patch format, "QLMP"
+     */
+    static const quint32 PatchMagic     = 0x514C4D50;
+
+    /**
+     * @brief The PatchOperation enum is the operations of the patch format
+     */
+    enum PatchOperation {
+        PatchInsert     = 0,
+        PatchRemove     = 1,
+        PatchChange     = 2,
+        PatchMove       = 3,
+        PatchNested     = 4
+    };
+
+    /**
+     * @brief Magic number of the schema format, "QLMS"
+     */
+    static const quint32 SchemaMagic    = 0x514C4D53;
+    static const quint16 SchemaVersion  = 1;
+
+    /**
+     * @brief The SchemaKind enum is the encoding of a column in the schema format
+     */
+    enum SchemaKind {
+        SchemaVariant   = 0,
+        SchemaString    = 1,
+        SchemaNested    = 2
+    };
+#endif
+
+#if UsingJson
+    virtual QJsonArray toJson(){
+        return QJsonArray();
+    }
+
+    virtual bool fromJson(QJsonArray array){
+        Q_UNUSED(array);
+        return false;
+    }
+
+    virtual bool jsonToObj(const QJsonValue &jsonValue, QObject *obj){
+        Q_UNUSED(jsonValue);
+        Q_UNUSED(obj);
+        return false;
+    }
+#endif
+
+protected:
+    inline void observeInserted(int first, int last){
+        if(!QmlListRowRegistry::isEmpty()){
+            for(int i = first; i <= last; ++i){
+                const QObject* obj = rowObject(i);
+                if(QmlListRowRegistry::contains(obj))
+                    QmlListRowRegistry::share(obj, this);
+            }
+        }
+        for(QmlListModelObserver* o : mObservers)
+            o->rowsInserted(first, last);
+    }
+
+    inline void observeAboutToBeRemoved(int first, int last){
+        for(QmlListModelObserver* o : mObservers)
+            o->rowsAboutToBeRemoved(first, last);
+    }
+
+    inline void observeRemoved(int first, int last){
+        for(QmlListModelObserver* o : mObservers)
+            o->rowsRemoved(first, last);
+    }
+
+    inline void observeAboutToChange(int first, int last, const QVector<int>& roles){
+        for(QmlListModelObserver* o : mObservers)
+            o->rowsAboutToChange(first, last, roles);
+        if(!QmlListRowRegistry::isEmpty() && !QmlListRowRegistry::FanOut::isActive())
+            fanOut(first, last, roles, true);
+    }
+
+    inline void observeChanged(int first, int last, const QVector<int>& roles){
+        for(QmlListModelObserver* o : mObservers)
+            o->rowsChanged(first, last, roles);
+        if(!QmlListRowRegistry::isEmpty() && !QmlListRowRegistry::FanOut::isActive())
+            fanOut(first, last, roles, false);
+    }
+
+    /**
+     * @brief rowsChangedElsewhere notifies rows changed through another model sharing them
+     * @param first
+     * @param last
+     * @param roles
+     */
+    virtual void rowsChangedElsewhere(int first, int last, const QVector<int>& roles){
+        observeChanged(first, last, roles);
+        emit dataChanged(index(first), index(last), roles);
+    }
+
+    /**
+     * @brief fanOut forwards a change of the shared rows to the other models holding them
+     */
+    inline void fanOut(int first, int last, const QVector<int>& roles, bool aboutToChange){
+        QmlListRowRegistry::FanOut fanOut;
+        for(int i = first; i <= last; ++i){
+            const QObject* obj = rowObject(i);
+            if(!QmlListRowRegistry::contains(obj))
+                continue;
+            for(QAbstractBase* model : QmlListRowRegistry::models(obj)){
+                const int j = model == this ? -1 : model->rowIndex(obj);
+                if(j < 0)
+                    continue;
+                if(aboutToChange)
+                    model->observeAboutToChange(j, j, roles);
+                else
+                    model->rowsChangedElsewhere(j, j, roles);
+            }
+        }
+    }
+
+    inline void observeMoved(int first, int last, int to){
+        for(QmlListModelObserver* o : mObservers)
+            o->rowsMoved(first, last, to);
+    }
+
+    /**
+     * @brief aggregate_
+     * @param role Role name
+     * @param operation "count", "sum", "avg", "min" or "max"
+     * @return The aggregate owned by the model, shared by the same role and operation
+     */
+    inline QmlListAggregate* aggregate_(const QString& role, const QString& operation);
+
+    /**
+     * @brief releaseLater deletes a removed row later, and counts it as pending until then.
+     * A row still held by another model is only released.
+     * @param obj
+     */
+    inline void releaseLater(QObject* obj){
+        if(obj == Q_NULLPTR)
+            return;
+        if(!QmlListRowRegistry::isEmpty() && !QmlListRowRegistry::release(obj, this)){
+#if UsingSerialize
+            /**
+              * The other models may outlive the buffer of this one
+              */
+            if(adoptsStrings())
+                detachStrings(obj);
+#endif
+            return;
+        }
+        obj->deleteLater();
+        if(mPendingDeletes++ == 0){
+            /**
+              * Queued behind the deferred deletes of this batch
+              */
+            QMetaObject::invokeMethod(this, [this](){
+                mPendingDeletes = 0;
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    QList<QmlListModelObserver*>        mObservers;
+    QmlListModelSnapshotTracker*        mSnapshotTracker = Q_NULLPTR;
+    QmlListViewportCache*               mViewport = Q_NULLPTR;
+    QmlListStringInterner*              mInterner = Q_NULLPTR;
+    QHash<QString, QmlListAggregate*>   mAggregates;
+    int                                 mPendingDeletes = 0;
+    Fetcher                             mFetcher;
+    int                                 mFetchPageSize = 256;
+    bool                                mFetchDone = true;
+    bool                                mFetching = false;
+#if UsingSerialize
+    QmlListModelPatchRecorder*          mPatchRecorder = Q_NULLPTR;
+    quint32                             mPatchRevision = 0;
+#endif
+#if UsingStats
+    QmlListModelStats*                  mStats = Q_NULLPTR;
+#endif
+};
+
+/**
+ * @brief The QmlListModelSnapshotTracker class keeps the row records of a model in chunks.
+ * A mutation only detaches the chunk it touches, every other chunk stays shared with the snapshots.
+ */
+class QmlListModelSnapshotTracker : public QmlListModelObserver
+{
+public:
+    /**
+     * @brief QmlListModelSnapshotTracker records the rows of model
+     * @param model
+     * @param tracking Whether the tracker observes the model and its nested models,
+     * otherwise it records the rows once for a single snapshot
+     */
+    explicit QmlListModelSnapshotTracker(QAbstractBase* model, bool tracking = true):
+        mModel(model), mTracking(tracking)
+    {
+        const QMetaObject* metaData = model->rowMetaObject();
+        mOffset = metaData->propertyOffset();
+        mMetaObject = metaData;
+        for(int i = mOffset; i < metaData->propertyCount(); ++i) {
+            const QMetaProperty& p = metaData->property(i);
+            mNames.append(QByteArray(p.name()));
+            mTypes.append(QAbstractBase::isSubList(p) ? qMetaTypeId<QmlListModelSnapshot>() : int(p.type()));
+        }
+        const int count = model->rowCount(QModelIndex());
+        if(count > 0)
+            rowsInserted(0, count - 1);
+    }
+
+    ~QmlListModelSnapshotTracker(){
+        for(const QVector<NestedWatch*>& watches : mWatches){
+            for(NestedWatch* w : watches)
+                unwatch(w);
+        }
+    }
+
+    inline QmlListModelSnapshot snapshot(){
+        /**
+          * Refresh the rows whose nested models have changed
+          */
+        for(QObject* owner : mStale){
+            const int i = mModel->rowIndex(owner);
+            if(i >= 0)
+                rowsChanged(i, i, QVector<int>());
+        }
+        mStale.clear();
+        return QmlListModelSnapshot(mNames, mTypes, mOffset, mRope);
+    }
+
+    void rowsInserted(int first, int last) override {
+        QVector<QmlListModelSnapshot::Row> rows;
+        rows.reserve(last - first + 1);
+        for(int i = first; i <= last; ++i)
+            rows.append(record(i));
+        insertRecords(first, rows);
+    }
+
+    void rowsAboutToBeRemoved(int first, int last) override {
+        for(int i = first; i <= last; ++i)
+            unwatchOwner(mModel->rowObject(i));
+    }
+
+    void rowsAboutToChange(int first, int last, const QVector<int>& roles) override {
+        /**
+          * The rows may be replaced, their nested models are watched again by rowsChanged()
+          */
+        if(!roles.isEmpty() || mWatches.isEmpty())
+            return;
+        for(int i = first; i <= last; ++i)
+            unwatchOwner(mModel->rowObject(i));
+    }
+
+    void rowsRemoved(int first, int last) override {
+        int count = last - first + 1, k, o;
+        while(count > 0){
+            locate(first, k, o);
+            if(k >= mRope.chunks.size())
+                break;
+            const int n = qMin(count, mRope.chunks.at(k).size() - o);
+            if(n == mRope.chunks.at(k).size()){
+                mRope.chunks.remove(k);
+                mRope.ends.remove(k);
+            } else {
+                mRope.chunks[k].remove(o, n);
+            }
+            count -= n;
+            updateEnds(k);
+        }
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        Q_UNUSED(roles);
+        for(int i = first; i <= last; ++i){
+            int k, o;
+            locate(i, k, o);
+            if(k < mRope.chunks.size() && o < mRope.chunks.at(k).size())
+                mRope.chunks[k][o] = record(i);
+        }
+    }
+
+    void rowsMoved(int first, int last, int to) override {
+        /**
+          * The records move unchanged, no row is read again
+          */
+        QVector<QmlListModelSnapshot::Row> rows;
+        rows.reserve(last - first + 1);
+        for(int i = first; i <= last; ++i){
+            int k, o;
+            locate(i, k, o);
+            rows.append(mRope.chunks.at(k).at(o));
+        }
+        rowsRemoved(first, last);
+        insertRecords(to, rows);
+    }
+
+    inline void markStale(QObject* owner){
+        mStale.insert(owner);
+    }
+
+private:
+    inline void insertRecords(int first, const QVector<QmlListModelSnapshot::Row>& rows){
+        int k, o;
+        locate(first, k, o);
+        if(k == mRope.chunks.size()){
+            mRope.chunks.append(QVector<QmlListModelSnapshot::Row>());
+            mRope.ends.append(first);
+        }
+        if(mRope.chunks.at(k).size() + rows.size() <= 2 * ChunkSize){
+            QVector<QmlListModelSnapshot::Row>& chunk = mRope.chunks[k];
+            chunk.insert(o, rows.size(), QmlListModelSnapshot::Row());
+            std::copy(rows.constBegin(), rows.constEnd(), chunk.begin() + o);
+            updateEnds(k);
+            return;
+        }
+        /**
+          * Lay the chunk and the rows out in chunks of ChunkSize rows in one pass
+          */
+        const QVector<QmlListModelSnapshot::Row> old = mRope.chunks.at(k);
+        QVector<QVector<QmlListModelSnapshot::Row> > pieces;
+        pieces.reserve((old.size() + rows.size()) / ChunkSize + 1);
+        QVector<QmlListModelSnapshot::Row> piece;
+        piece.reserve(ChunkSize);
+        const auto put = [&](const QmlListModelSnapshot::Row& r){
+            piece.append(r);
+            if(piece.size() == ChunkSize){
+                pieces.append(piece);
+                piece = QVector<QmlListModelSnapshot::Row>();
+                piece.reserve(ChunkSize);
+            }
+        };
+        for(int i = 0; i < o; ++i)
+            put(old.at(i));
+        for(const QmlListModelSnapshot::Row& r : rows)
+            put(r);
+        for(int i = o; i < old.size(); ++i)
+            put(old.at(i));
+        if(!piece.isEmpty())
+            pieces.append(piece);
+        mRope.chunks.insert(k + 1, pieces.size() - 1, QVector<QmlListModelSnapshot::Row>());
+        mRope.ends.insert(k + 1, pieces.size() - 1, 0);
+        for(int p = 0; p < pieces.size(); ++p)
+            mRope.chunks[k + p].swap(pieces[p]);
+        updateEnds(k);
+    }
+
+    /**
+     * @brief The NestedWatch class marks the owner row stale when its nested model changes
+     */
+    struct NestedWatch : public QmlListModelObserver {
+        QmlListModelSnapshotTracker*    tracker;
+        QObject*                        owner;
+        QPointer<QAbstractBase>         model;
+
+        void rowsInserted(int, int) override { tracker->markStale(owner); }
+        void rowsRemoved(int, int) override { tracker->markStale(owner); }
+        void rowsChanged(int, int, const QVector<int>&) override { tracker->markStale(owner); }
+        void rowsMoved(int, int, int) override { tracker->markStale(owner); }
+    };
+
+    static const int ChunkSize = 512;
+
+    inline void locate(int i, int& chunk, int& offset) const {
+        chunk = int(std::upper_bound(mRope.ends.constBegin(), mRope.ends.constEnd(), i) - mRope.ends.constBegin());
+        if(chunk == mRope.chunks.size() && chunk > 0 && mRope.chunks.last().size() < 2 * ChunkSize){
+            /**
+              * Append to the last chunk
+              */
+            --chunk;
+        }
+        offset = i - (chunk == 0 ? 0 : mRope.ends.at(chunk - 1));
+    }
+
+    inline void updateEnds(int from){
+        int end = from == 0 ? 0 : mRope.ends.at(from - 1);
+        for(int k = from; k < mRope.chunks.size(); ++k){
+            end += mRope.chunks.at(k).size();
+            mRope.ends[k] = end;
+        }
+    }
+
+    inline QmlListModelSnapshot::Row record(int i){
+        QmlListModelSnapshot::Row r;
+        QObject* obj = mModel->rowObject(i);
+        r.object = obj;
+        if(obj == Q_NULLPTR)
+            return r;
+        r.values.reserve(mNames.size());
+        for(int j = mOffset; j < mOffset + mNames.size(); ++j) {
+            const QMetaProperty& p = mMetaObject->property(j);
+            if(QAbstractBase::isSubList(p)){
+                QAbstractBase* subList = QAbstractBase::subList(p, obj);
+                if(subList != Q_NULLPTR){
+                    if(mTracking)
+                        watch(obj, subList);
+                    r.values.append(QVariant::fromValue(subList->snapshot()));
+                } else {
+                    r.values.append(QVariant());
+                }
+            } else {
+                r.values.append(p.read(obj));
+#if UsingSerialize
+                /**
+                  * The snapshots may outlive the buffer of adopted strings
+                  */
+                if(p.userType() == QMetaType::QString && mModel->adoptsStrings()){
+                    const QString& v = r.values.last().toString();
+                    r.values.last() = QString(v.constData(), v.size());
+                }
+#endif
+            }
+        }
+        return r;
+    }
+
+    inline void watch(QObject* owner, QAbstractBase* subList){
+        QVector<NestedWatch*>& watches = mWatches[owner];
+        for(NestedWatch* w : watches){
+            if(w->model == subList)
+                return;
+        }
+        NestedWatch* w = new NestedWatch;
+        w->tracker = this;
+        w->owner = owner;
+        w->model = subList;
+        subList->addObserver(w);
+        watches.append(w);
+    }
+
+    inline void unwatch(NestedWatch* w){
+        if(!w->model.isNull())
+            w->model->removeObserver(w);
+        delete w;
+    }
+
+    inline void unwatchOwner(QObject* owner){
+        if(owner == Q_NULLPTR)
+            return;
+        for(NestedWatch* w : mWatches.take(owner))
+            unwatch(w);
+        mStale.remove(owner);
+    }
+
+    QAbstractBase*                          mModel;
+    bool                                    mTracking;
+    const QMetaObject*                      mMetaObject;
+    QVector<QByteArray>                     mNames;
+    QVector<int>                            mTypes;
+    int                                     mOffset;
+    QmlListModelSnapshot::Rope              mRope;
+    QSet<QObject*>                          mStale;
+    QHash<QObject*, QVector<NestedWatch*> > mWatches;
+};
+
+#if UsingSerialize
+/**
+ * @brief The QmlListModelPatchRecorder class encodes the mutations of a model as they happen.
+ * Rows are addressed by their index at the time of the operation, so a patch
+ * must be applied in order on a mirror at the same revision.
+ * Operations: insert (first, count, rows), remove (first, count),
+ * change (first, count, roles, values of the roles per row, no roles for all), move (first, count, to),
+ * nested (owner row, property, toBytes of the nested model).
+ * A change of the same rows and roles as the previous operation replaces it.
+ * The nested models of the rows, at any depth, are watched: a change inside them marks the owner row,
+ * and take() appends one nested operation per marked row with the nested model as it is then.
+ */
+class QmlListModelPatchRecorder : public QmlListModelObserver
+{
+public:
+    explicit QmlListModelPatchRecorder(QAbstractBase* model):
+        mModel(model), mStream(&mOperations, QIODevice::WriteOnly), mCount(0),
+        mLastChange(-1), mLastFirst(-1), mLastRows(0)
+    {
+        watchRows(model, Q_NULLPTR, 0, model->rowCount(QModelIndex()) - 1);
+    }
+
+    ~QmlListModelPatchRecorder(){
+        for(const QVector<NestedWatch*>& watches : mWatches){
+            for(NestedWatch* w : watches)
+                unwatch(w);
+        }
+    }
+
+    void rowsInserted(int first, int last) override {
+        mLastChange = -1;
+        ++mCount;
+        mStream << quint8(QAbstractBase::PatchInsert) << quint32(first) << quint32(last - first + 1);
+        for(int i = first; i <= last; ++i)
+            QAbstractBase::writeRow(mStream, mModel->rowObject(i));
+        watchRows(mModel, Q_NULLPTR, first, last);
+    }
+
+    void rowsAboutToBeRemoved(int first, int last) override {
+        for(int i = first; i <= last; ++i)
+            unwatchOwner(mModel->rowObject(i));
+    }
+
+    void rowsAboutToChange(int first, int last, const QVector<int>& roles) override {
+        /**
+          * The rows may be replaced, they are watched again by rowsChanged()
+          */
+        if(!roles.isEmpty())
+            return;
+        for(int i = first; i <= last; ++i)
+            unwatchOwner(mModel->rowObject(i));
+    }
+
+    void rowsRemoved(int first, int last) override {
+        mLastChange = -1;
+        ++mCount;
+        mStream << quint8(QAbstractBase::PatchRemove) << quint32(first) << quint32(last - first + 1);
+    }
+
+    void rowsMoved(int first, int last, int to) override {
+        mLastChange = -1;
+        ++mCount;
+        mStream << quint8(QAbstractBase::PatchMove) << quint32(first) << quint32(last - first + 1) << quint32(to);
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        const int rows = last - first + 1;
+        if(mLastChange >= 0 && mLastFirst == first && mLastRows == rows && mLastRoles == roles){
+            /**
+              * Overwrite the previous values of the same rows and roles
+              */
+            mStream.device()->seek(mLastChange);
+            mOperations.truncate(int(mLastChange));
+        } else {
+            mLastChange = mStream.device()->pos();
+            mLastFirst = first;
+            mLastRows = rows;
+            mLastRoles = roles;
+            ++mCount;
+        }
+        const QMetaObject* metaData = mModel->rowMetaObject();
+        mStream << quint8(QAbstractBase::PatchChange) << quint32(first) << quint32(rows) << quint16(roles.size());
+        for(int r : roles)
+            mStream << quint16(r);
+        bool nested = roles.isEmpty();
+        for(int r : roles)
+            nested = nested || QAbstractBase::isSubList(metaData->property(r));
+        for(int i = first; i <= last; ++i){
+            const QObject* obj = mModel->rowObject(i);
+            if(roles.isEmpty()){
+                QAbstractBase::writeRow(mStream, obj);
+            } else {
+                for(int r : roles)
+                    QAbstractBase::writeProperty(mStream, metaData->property(r), obj);
+            }
+        }
+        if(nested)
+            watchRows(mModel, Q_NULLPTR, first, last);
+    }
+
+    /**
+     * @brief take
+     * @param baseRevision
+     * @return The recorded operations behind the patch header, then starts a new patch
+     */
+    QByteArray take(quint32 baseRevision){
+        /**
+          * The nested operations address the rows as they are now, behind all the other operations
+          */
+        const QMetaObject* metaData = mModel->rowMetaObject();
+        for(QObject* owner : mNested){
+            const int row = mModel->rowIndex(owner);
+            if(row < 0)
+                continue;
+            for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j){
+                const QMetaProperty& p = metaData->property(j);
+                if(!QAbstractBase::isSubList(p))
+                    continue;
+                QByteArray nested;
+                QDataStream n(&nested, QIODevice::WriteOnly);
+                n.setVersion(mStream.version());
+                QAbstractBase::writeProperty(n, p, owner);
+                mStream << quint8(QAbstractBase::PatchNested) << quint32(row) << quint16(j) << nested;
+                ++mCount;
+            }
+        }
+        mNested.clear();
+        QByteArray patch;
+        QDataStream s(&patch, QIODevice::WriteOnly);
+        s << quint32(QAbstractBase::PatchMagic) << baseRevision << quint32(baseRevision + 1) << mCount;
+        s.writeRawData(mOperations.constData(), mOperations.size());
+        mStream.device()->seek(0);
+        mOperations.clear();
+        mCount = 0;
+        mLastChange = -1;
+        return patch;
+    }
+
+    inline bool isEmpty() const {
+        return mCount == 0 && mNested.isEmpty();
+    }
+
+    inline void markNested(QObject* owner){
+        mNested.insert(owner);
+    }
+
+    /**
+     * @brief watchRows watches the nested models of the rows first to last of model and theirs,
+     * on behalf of owner, the row of the recorded model they belong to, or the row itself if null
+     */
+    void watchRows(QAbstractBase* model, QObject* owner, int first, int last){
+        const QMetaObject* metaData = model->rowMetaObject();
+        if(metaData == Q_NULLPTR)
+            return;
+        for(int i = first; i <= last; ++i){
+            QObject* obj = model->rowObject(i);
+            if(obj == Q_NULLPTR)
+                continue;
+            for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j){
+                const QMetaProperty& p = metaData->property(j);
+                QAbstractBase* list = QAbstractBase::isSubList(p) ? QAbstractBase::subList(p, obj) : Q_NULLPTR;
+                if(list != Q_NULLPTR && watch(owner == Q_NULLPTR ? obj : owner, list))
+                    watchRows(list, owner == Q_NULLPTR ? obj : owner, 0, list->rowCount(QModelIndex()) - 1);
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief The NestedWatch class marks the owner row when a nested model below it changes
+     */
+    struct NestedWatch : public QmlListModelObserver {
+        QmlListModelPatchRecorder*      recorder;
+        QObject*                        owner;
+        QPointer<QAbstractBase>         model;
+
+        void rowsInserted(int first, int last) override {
+            recorder->markNested(owner);
+            recorder->watchRows(model, owner, first, last);
+        }
+        void rowsRemoved(int, int) override { recorder->markNested(owner); }
+        void rowsChanged(int first, int last, const QVector<int>&) override {
+            recorder->markNested(owner);
+            recorder->watchRows(model, owner, first, last);
+        }
+        void rowsMoved(int, int, int) override { recorder->markNested(owner); }
+    };
+
+    /**
+     * @brief watch
+     * @return Whether list was not watched for owner yet
+     */
+    inline bool watch(QObject* owner, QAbstractBase* list){
+        QVector<NestedWatch*>& watches = mWatches[owner];
+        for(NestedWatch* w : watches){
+            if(w->model == list)
+                return false;
+        }
+        NestedWatch* w = new NestedWatch;
+        w->recorder = this;
+        w->owner = owner;
+        w->model = list;
+        list->addObserver(w);
+        watches.append(w);
+        return true;
+    }
+
+    inline void unwatch(NestedWatch* w){
+        if(!w->model.isNull())
+            w->model->removeObserver(w);
+        delete w;
+    }
+
+    inline void unwatchOwner(QObject* owner){
+        if(owner == Q_NULLPTR)
+            return;
+        for(NestedWatch* w : mWatches.take(owner))
+            unwatch(w);
+        mNested.remove(owner);
+    }
+
+    QAbstractBase*  mModel;
+    QByteArray      mOperations;
+    QDataStream     mStream;
+    quint32         mCount;
+    qint64          mLastChange;
+    int             mLastFirst;
+    int             mLastRows;
+    QVector<int>    mLastRoles;
+    QSet<QObject*>  mNested;
+    QHash<QObject*, QVector<NestedWatch*> > mWatches;
+};
+
+inline void QAbstractBase::setPatchRecording(bool recording)
+{
+    if(recording == isPatchRecording())
+        return;
+    if(recording){
+        mPatchRecorder = new QmlListModelPatchRecorder(this);
+        addObserver(mPatchRecorder);
+    } else {
+        removeObserver(mPatchRecorder);
+        delete mPatchRecorder;
+        mPatchRecorder = Q_NULLPTR;
+    }
+}
+
+inline QByteArray QAbstractBase::takePatch()
+{
+    if(mPatchRecorder == Q_NULLPTR || mPatchRecorder->isEmpty())
+        return QByteArray();
+    return mPatchRecorder->take(mPatchRevision++);
+}
+#endif
+
+/**
+ * @brief The QmlListAggregate class maintains count, sum, average, min or max of a role.
+ * Inserted, removed and changed rows update it incrementally: count and sum in O(1),
+ * min and max in O(log n) by an ordered multiset of the values.
+ * Only a full recompute, on creation, reads all rows, on the model thread,
+ * and sorts their values concurrently for min and max.
+ */
+class QmlListAggregate : public QObject, public QmlListModelObserver
+{
+    Q_OBJECT
+    Q_PROPERTY(QString role READ role CONSTANT)
+    Q_PROPERTY(QString operation READ operation CONSTANT)
+    Q_PROPERTY(QVariant value READ value NOTIFY valueChanged)
+public:
+    enum Operation {
+        Count,
+        Sum,
+        Average,
+        Min,
+        Max
+    };
+
+    QmlListAggregate(QAbstractBase* model, int property, Operation operation, QObject* parent = 0):
+        QObject(parent), mModel(model), mProperty(property), mOperation(operation),
+        mRows(0), mNumbers(0), mSum(0)
+    {
+        recompute();
+    }
+
+    /**
+     * @brief operationFromString
+     * @param operation
+     * @param ok
+     * @return
+     */
+    static inline Operation operationFromString(const QString& operation, bool* ok){
+        *ok = true;
+        const QString& o = operation.toLower();
+        if(o == QLatin1String("count"))
+            return Count;
+        if(o == QLatin1String("sum"))
+            return Sum;
+        if(o == QLatin1String("avg") || o == QLatin1String("average"))
+            return Average;
+        if(o == QLatin1String("min"))
+            return Min;
+        if(o == QLatin1String("max"))
+            return Max;
+        *ok = false;
+        return Count;
+    }
+
+    inline QString role() const {
+        return QString::fromLatin1(mModel->rowMetaObject()->property(mProperty).name());
+    }
+
+    inline QString operation() const {
+        static const char* names[] = {"count", "sum", "avg", "min", "max"};
+        return QString::fromLatin1(names[mOperation]);
+    }
+
+    /**
+     * @brief value
+     * @return The aggregate, undefined for the average, min and max of no numbers
+     */
+    inline QVariant value() const {
+        switch (mOperation) {
+        case Count:
+            return mRows;
+        case Sum:
+            return mSum;
+        case Average:
+            return mNumbers == 0 ? QVariant() : QVariant(mSum / mNumbers);
+        case Min:
+            return mValues.isEmpty() ? QVariant() : QVariant(mValues.firstKey());
+        case Max:
+            return mValues.isEmpty() ? QVariant() : QVariant(mValues.lastKey());
+        }
+        return QVariant();
+    }
+
+    /**
+     * @brief recompute reads all rows on the model thread, the rows are QObjects
+     * of that thread, then sorts the values concurrently for min and max
+     */
+    void recompute(){
+        const int count = mModel->rowCount(QModelIndex());
+        const bool ordered = mOperation == Min || mOperation == Max;
+        QVector<double> numbers;
+        numbers.reserve(count);
+        mRows = count;
+        mSum = 0;
+        mValues.clear();
+        for(int i = 0; i < count; ++i){
+            double v;
+            if(read(i, &v)){
+                numbers.append(v);
+                mSum += v;
+            }
+        }
+        mNumbers = numbers.size();
+        if(ordered){
+            /**
+              * Sort the chunks concurrently, merge them and build the multiset in order
+              */
+            const int chunks = (mNumbers + ChunkSize - 1) / ChunkSize;
+            double* values = numbers.data();
+            QmlListModelParallel::run(chunks, QThread::idealThreadCount(), [&](int k){
+                std::sort(values + k * ChunkSize, values + qMin(mNumbers, (k + 1) * ChunkSize));
+            });
+            for(int k = 1; k < chunks; ++k)
+                std::inplace_merge(values, values + k * ChunkSize, values + qMin(mNumbers, (k + 1) * ChunkSize));
+            for(double v : numbers){
+                if(!mValues.isEmpty() && mValues.lastKey() == v)
+                    ++(mValues.end() - 1).value();
+                else
+                    mValues.insert(mValues.constEnd(), v, 1);
+            }
+        }
+        emit valueChanged();
+    }
+
+    void rowsInserted(int first, int last) override {
+        mRows += last - first + 1;
+        for(int i = first; i <= last; ++i)
+            add(i);
+        emit valueChanged();
+    }
+
+    void rowsAboutToBeRemoved(int first, int last) override {
+        mRows -= last - first + 1;
+        if(mRows == 0){
+            mNumbers = 0;
+            mSum = 0;
+            mValues.clear();
+        } else {
+            for(int i = first; i <= last; ++i)
+                remove(i);
+        }
+        emit valueChanged();
+    }
+
+    void rowsAboutToChange(int first, int last, const QVector<int>& roles) override {
+        if(!roles.isEmpty() && !roles.contains(mProperty))
+            return;
+        for(int i = first; i <= last; ++i)
+            remove(i);
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        if(!roles.isEmpty() && !roles.contains(mProperty))
+            return;
+        for(int i = first; i <= last; ++i)
+            add(i);
+        emit valueChanged();
+    }
+
+signals:
+    void valueChanged();
+
+private:
+    static const int ChunkSize = 4096;
+
+    inline bool read(int i, double* v) const {
+        QObject* obj = mModel->rowObject(i);
+        if(obj == Q_NULLPTR)
+            return false;
+        bool ok;
+        *v = mModel->rowMetaObject()->property(mProperty).read(obj).toDouble(&ok);
+        return ok;
+    }
+
+    inline void add(int i){
+        double v;
+        if(!read(i, &v))
+            return;
+        ++mNumbers;
+        mSum += v;
+        if(mOperation == Min || mOperation == Max)
+            ++mValues[v];
+    }
+
+    inline void remove(int i){
+        double v;
+        if(!read(i, &v))
+            return;
+        --mNumbers;
+        mSum -= v;
+        if(mOperation == Min || mOperation == Max){
+            auto it = mValues.find(v);
+            if(it != mValues.end() && --it.value() <= 0)
+                mValues.erase(it);
+        }
+    }
+
+    QAbstractBase*      mModel;
+    int                 mProperty;
+    Operation           mOperation;
+    int                 mRows;
+    int                 mNumbers;
+    double              mSum;
+    QMap<double, int>   mValues;
+};
+
+#if UsingStats
+/**
+ * @brief The QmlListModelStats class counts the activity of one model.
+ * The counters are read by QML through properties, changed() is emitted at most once per second
+ * by one timer of the application thread shared by all the models.
+ */
+class QmlListModelStats : public QObject, public QmlListModelObserver
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 dataCalls READ dataCalls NOTIFY changed)
+    Q_PROPERTY(QVariantMap dataCallsPerRole READ dataCallsPerRole NOTIFY changed)
+    Q_PROPERTY(qint64 getCalls READ getCalls NOTIFY changed)
+    Q_PROPERTY(qint64 rowsInserted READ rowsInsertedCount NOTIFY changed)
+    Q_PROPERTY(qint64 rowsRemoved READ rowsRemovedCount NOTIFY changed)
+    Q_PROPERTY(qint64 dataChangedEmitted READ dataChangedEmitted NOTIFY changed)
+    Q_PROPERTY(double fromJsonMs READ fromJsonMs NOTIFY changed)
+    Q_PROPERTY(double toJsonMs READ toJsonMs NOTIFY changed)
+    Q_PROPERTY(double fromBytesMs READ fromBytesMs NOTIFY changed)
+    Q_PROPERTY(double toBytesMs READ toBytesMs NOTIFY changed)
+public:
+    enum Timing {
+        FromJson,
+        ToJson,
+        FromBytes,
+        ToBytes,
+        TimingCount
+    };
+
+    /**
+     * @brief The Scope class times a conversion and records its trace event
+     */
+    class Scope
+    {
+    public:
+        inline Scope(QmlListModelStats* stats, Timing timing):
+            mStats(stats), mTiming(timing), mBegin(QmlListModelTrace::now()){
+            mTimer.start();
+        }
+
+        inline ~Scope(){
+            const qint64 ns = mTimer.nsecsElapsed();
+            mStats->mTimings[mTiming].fetchAndAddRelaxed(ns);
+            mStats->touch();
+            if(QmlListModelTrace::isEnabled())
+                QmlListModelTrace::complete(timingName(mTiming), mStats->category(), mBegin, ns / 1000);
+#ifdef QML_LIST_MODEL_TRACEPOINT
+            QML_LIST_MODEL_TRACEPOINT(timingName(mTiming), mStats->mModel);
+#endif
+        }
+
+    private:
+        QmlListModelStats*  mStats;
+        Timing              mTiming;
+        qint64              mBegin;
+        QElapsedTimer       mTimer;
+    };
+
+    /**
+      * Roles counted one by one, the role ids are the property indices of the row type
+      */
+    static const int MaxRoles = 128;
+
+    explicit QmlListModelStats(QAbstractBase* model):
+        QObject(model), mModel(model), mDirty(0)
+    {
+        Ticker& t = ticker();
+        QMutexLocker lock(&t.mutex);
+        t.stats.insert(this);
+        if(!t.started && QCoreApplication::instance() != Q_NULLPTR){
+            /**
+              * Models may be created on worker threads, the timer is started on the application thread
+              */
+            t.started = true;
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [](){
+                QTimer* timer = new QTimer(QCoreApplication::instance());
+                QObject::connect(timer, &QTimer::timeout, &QmlListModelStats::tick);
+                timer->start(1000);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    ~QmlListModelStats(){
+        Ticker& t = ticker();
+        QMutexLocker lock(&t.mutex);
+        t.stats.remove(this);
+    }
+
+    inline void dataCalled(int role){
+        mDataCalls.fetchAndAddRelaxed(1);
+        if(role >= 0 && role < MaxRoles)
+            mRoleCalls[role].fetchAndAddRelaxed(1);
+        touch();
+    }
+
+    inline void getCalled(){
+        mGetCalls.fetchAndAddRelaxed(1);
+        touch();
+    }
+
+    inline void dataChangedSent(int count){
+        mDataChanged.fetchAndAddRelaxed(quint64(count));
+        touch();
+    }
+
+    inline qint64 dataCalls() const { return qint64(mDataCalls.loadAcquire()); }
+    inline qint64 getCalls() const { return qint64(mGetCalls.loadAcquire()); }
+    inline qint64 rowsInsertedCount() const { return qint64(mRowsInserted.loadAcquire()); }
+    inline qint64 rowsRemovedCount() const { return qint64(mRowsRemoved.loadAcquire()); }
+    inline qint64 dataChangedEmitted() const { return qint64(mDataChanged.loadAcquire()); }
+    inline double fromJsonMs() const { return mTimings[FromJson].loadAcquire() / 1e6; }
+    inline double toJsonMs() const { return mTimings[ToJson].loadAcquire() / 1e6; }
+    inline double fromBytesMs() const { return mTimings[FromBytes].loadAcquire() / 1e6; }
+    inline double toBytesMs() const { return mTimings[ToBytes].loadAcquire() / 1e6; }
+
+    inline QVariantMap dataCallsPerRole() const {
+        QVariantMap calls;
+        const QMetaObject* meta = mModel->rowMetaObject();
+        for(int i = 0; i < MaxRoles; ++i){
+            const quint64 c = mRoleCalls[i].loadAcquire();
+            if(c > 0)
+                calls.insert(meta != Q_NULLPTR && i < meta->propertyCount() ?
+                                 QString::fromLatin1(meta->property(i).name()) : QString::number(i), qint64(c));
+        }
+        return calls;
+    }
+
+    Q_INVOKABLE void reset(){
+        mDataCalls.storeRelease(0);
+        mGetCalls.storeRelease(0);
+        mRowsInserted.storeRelease(0);
+        mRowsRemoved.storeRelease(0);
+        mDataChanged.storeRelease(0);
+        for(int i = 0; i < MaxRoles; ++i)
+            mRoleCalls[i].storeRelease(0);
+        for(int i = 0; i < TimingCount; ++i)
+            mTimings[i].storeRelease(0);
+        emit changed();
+    }
+
+    void rowsInserted(int first, int last) override {
+        mRowsInserted.fetchAndAddRelaxed(quint64(last - first + 1));
+        touch();
+    }
+
+    void rowsRemoved(int first, int last) override {
+        mRowsRemoved.fetchAndAddRelaxed(quint64(last - first + 1));
+        touch();
+    }
+
+signals:
+    void changed();
+
+private:
+    struct Ticker {
+        QMutex                      mutex;
+        QSet<QmlListModelStats*>    stats;
+        bool                        started = false;
+    };
+
+    static inline Ticker& ticker(){
+        static Ticker t;
+        return t;
+    }
+
+    /**
+     * @brief tick emits changed() of the touched stats of the application thread,
+     * outside the lock since a slot may create or delete a model
+     */
+    static void tick(){
+        QVector<QPointer<QmlListModelStats> > touched;
+        {
+            Ticker& t = ticker();
+            QMutexLocker lock(&t.mutex);
+            for(QmlListModelStats* s : t.stats){
+                if(s->thread() == QThread::currentThread() && s->mDirty.fetchAndStoreRelaxed(0))
+                    touched.append(s);
+            }
+        }
+        for(const QPointer<QmlListModelStats>& s : touched){
+            if(!s.isNull())
+                emit s->changed();
+        }
+    }
+
+    static inline const char* timingName(Timing timing){
+        static const char* names[] = {"fromJson", "toJson", "fromBytes", "toBytes"};
+        return names[timing];
+    }
+
+    inline void touch(){
+        mDirty.storeRelease(1);
+    }
+
+    inline const char* category() const {
+        const QMetaObject* meta = mModel->rowMetaObject();
+        return meta == Q_NULLPTR ? "QmlListModel" : meta->className();
+    }
+
+    QAbstractBase*                                  mModel;
+    QAtomicInteger<quint64>                         mRoleCalls[MaxRoles];
+    QAtomicInteger<quint64>                         mDataCalls;
+    QAtomicInteger<quint64>                         mGetCalls;
+    QAtomicInteger<quint64>                         mRowsInserted;
+    QAtomicInteger<quint64>                         mRowsRemoved;
+    QAtomicInteger<quint64>                         mDataChanged;
+    QAtomicInteger<qint64>                          mTimings[TimingCount];
+    QAtomicInt                                      mDirty;
+};
+
+#endif
+
+/**
+ * @brief The QmlListViewportCache class keeps the bound roles of the rows around a viewport
+ * in one flat array, row by row, so data() is an index lookup instead of a meta property read.
+ * It is refilled on the model thread when the viewport moves or the rows change,
+ * reusing the values of the rows still in range. Every dataChanged() of the model is
+ * preceded by rowsChanged(), so the cache is refreshed once and before the views read it.
+ */
+class QmlListViewportCache : public QmlListModelObserver
+{
+public:
+    explicit QmlListViewportCache(QAbstractBase* model):
+        mModel(model), mFirst(0), mLast(-1), mCacheFirst(0), mCacheCount(0), mHits(0), mMisses(0){}
+
+    /**
+     * @brief setRoles
+     * @param properties The cached property indices
+     */
+    inline void setRoles(const QVector<int>& properties){
+        if(properties == mProperties)
+            return;
+        mProperties = properties;
+        int size = 0;
+        for(int property : properties)
+            size = qMax(size, property + 1);
+        mSlots.fill(-1, size);
+        for(int k = 0; k < properties.size(); ++k)
+            mSlots[properties.at(k)] = k;
+        mCacheCount = 0;
+        mValues.clear();
+    }
+
+    /**
+     * @brief setViewport refills the cache for the visible rows and the rows ahead
+     * @param first
+     * @param last
+     * @return The last row cached
+     */
+    int setViewport(int first, int last);
+
+    /**
+     * @brief find
+     * @param row
+     * @param role
+     * @return The cached value, null on a miss
+     */
+    inline const QVariant* find(int row, int role) const {
+        const unsigned r = unsigned(row - mCacheFirst);
+        const int slot = unsigned(role) < unsigned(mSlots.size()) ? mSlots.at(role) : -1;
+        if(r >= unsigned(mCacheCount) || slot < 0){
+            ++mMisses;
+            return Q_NULLPTR;
+        }
+        ++mHits;
+        return &mValues.at(int(r) * mProperties.size() + slot);
+    }
+
+    inline quint64 hits() const {
+        return mHits;
+    }
+
+    inline quint64 misses() const {
+        return mMisses;
+    }
+
+    void rowsInserted(int first, int last) override {
+        Q_UNUSED(last)
+        if(first <= mCacheFirst + mCacheCount - 1)
+            refill();
+    }
+
+    void rowsRemoved(int first, int last) override {
+        Q_UNUSED(last)
+        if(first <= mCacheFirst + mCacheCount - 1)
+            refill();
+    }
+
+    void rowsMoved(int first, int last, int to) override {
+        if(qMin(first, to) <= mCacheFirst + mCacheCount - 1 && qMax(last, to + last - first) >= mCacheFirst)
+            refill();
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        const int from = qMax(first, mCacheFirst),
+                  to = qMin(last, mCacheFirst + mCacheCount - 1);
+        for(int i = from; i <= to; ++i){
+            for(int k = 0; k < mProperties.size(); ++k){
+                if(roles.isEmpty() || roles.contains(mProperties.at(k)))
+                    mValues[(i - mCacheFirst) * mProperties.size() + k] = read(i, mProperties.at(k));
+            }
+        }
+    }
+
+private:
+    inline void refill(){
+        mCacheCount = 0;
+        mValues.clear();
+        setViewport(mFirst, mLast);
+    }
+
+    inline QVariant read(int i, int property) const;
+
+    QAbstractBase*      mModel;
+    QVector<int>        mProperties;
+    QVector<int>        mSlots;
+    QVector<QVariant>   mValues;
+    int                 mFirst;
+    int                 mLast;
+    int                 mCacheFirst;
+    int                 mCacheCount;
+    mutable quint64     mHits;
+    mutable quint64     mMisses;
+};
+
+inline QVariant QmlListViewportCache::read(int i, int property) const
+{
+    const QObject* obj = mModel->rowObject(i);
+    return obj == Q_NULLPTR ? QVariant() : obj->metaObject()->property(property).read(obj);
+}
+
+inline int QmlListViewportCache::setViewport(int first, int last)
+{
+    mFirst = first;
+    mLast = last;
+    const int count = mModel->rowCount(QModelIndex()),
+              ahead = qMin(256, last - first + 1),
+              from = qBound(0, first - ahead, count),
+              to = qBound(from - 1, last + ahead, count - 1),
+              width = mProperties.size();
+    QVector<QVariant> values;
+    values.reserve((to - from + 1) * width);
+    for(int i = from; i <= to; ++i){
+        if(i >= mCacheFirst && i < mCacheFirst + mCacheCount){
+            const int j = (i - mCacheFirst) * width;
+            for(int k = 0; k < width; ++k)
+                values.append(mValues.at(j + k));
+        } else {
+            for(int k = 0; k < width; ++k)
+                values.append(read(i, mProperties.at(k)));
+        }
+    }
+    mValues.swap(values);
+    mCacheFirst = from;
+    mCacheCount = to - from + 1;
+    return to;
+}
+
+inline void QAbstractBase::setViewport_(int first, int last, const QStringList &roles)
+{
+    const QMetaObject* metaData = rowMetaObject();
+    if(metaData == Q_NULLPTR || first < 0 || last < first){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong viewport."<<first<<last;
+        return;
+    }
+    QVector<int> properties;
+    if(roles.isEmpty()){
+        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j){
+            if(!isSubList(metaData->property(j)))
+                properties.append(j);
+        }
+    } else {
+        for(const QString& role : roles){
+            const int j = metaData->indexOfProperty(role.toLatin1().constData());
+            if(j >= 0)
+                properties.append(j);
+            else
+                qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong role."<<role;
+        }
+    }
+    if(mViewport == Q_NULLPTR){
+        mViewport = new QmlListViewportCache(this);
+        addObserver(mViewport);
+    }
+    mViewport->setRoles(properties);
+    const int cached = mViewport->setViewport(first, last);
+    if(cached >= rowCount(QModelIndex()) - 1 && canFetchMore(QModelIndex()))
+        fetchMore(QModelIndex());
+}
+
+inline void QAbstractBase::clearViewport()
+{
+    if(mViewport == Q_NULLPTR)
+        return;
+    removeObserver(mViewport);
+    delete mViewport;
+    mViewport = Q_NULLPTR;
+}
+
+inline quint64 QAbstractBase::viewportHits() const
+{
+    return mViewport == Q_NULLPTR ? 0 : mViewport->hits();
+}
+
+inline quint64 QAbstractBase::viewportMisses() const
+{
+    return mViewport == Q_NULLPTR ? 0 : mViewport->misses();
+}
+
+/**
+ * @brief The QmlListStringInterner class replaces the values of the interned roles by their
+ * pooled copy on every insertion and change. It observes the model before the other observers,
+ * so the snapshots and the aggregates see the pooled strings.
+ */
+class QmlListStringInterner : public QmlListModelObserver
+{
+public:
+    explicit QmlListStringInterner(QAbstractBase* model):
+        mModel(model){}
+
+    inline void setProperties(const QVector<int>& properties){
+        QHash<int, QmlListStringPool> pools;
+        for(int property : properties)
+            pools.insert(property, mPools.value(property));
+        mPools.swap(pools);
+    }
+
+    inline QVector<int> properties() const {
+        return mPools.keys().toVector();
+    }
+
+    inline const QmlListStringPool* pool(int property) const {
+        auto it = mPools.constFind(property);
+        return it == mPools.constEnd() ? Q_NULLPTR : &it.value();
+    }
+
+    inline qint64 bytes() const {
+        qint64 b = 0;
+        for(const QmlListStringPool& pool : mPools)
+            b += pool.bytes();
+        return b;
+    }
+
+    inline int squeeze(){
+        int dropped = 0;
+        for(QmlListStringPool& pool : mPools)
+            dropped += pool.squeeze();
+        return dropped;
+    }
+
+    void rowsInserted(int first, int last) override {
+        for(int i = first; i <= last; ++i)
+            internRow(i, QVector<int>());
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        for(int i = first; i <= last; ++i)
+            internRow(i, roles);
+    }
+
+private:
+    inline void internRow(int i, const QVector<int>& roles){
+        QObject* obj = mModel->rowObject(i);
+        if(obj == Q_NULLPTR)
+            return;
+        for(auto it = mPools.begin(); it != mPools.end(); ++it){
+            if(!roles.isEmpty() && !roles.contains(it.key()))
+                continue;
+            const QMetaProperty& p = obj->metaObject()->property(it.key());
+            const QString& value = p.read(obj).toString();
+            if(value.isEmpty())
+                continue;
+            const QString& pooled = it->intern(value);
+            if(pooled.constData() != value.constData())
+                p.write(obj, pooled);
+        }
+    }
+
+    QAbstractBase*                  mModel;
+    QHash<int, QmlListStringPool>   mPools;
+};
+
+inline void QAbstractBase::setInternedRoles(const QStringList &roles)
+{
+    if(roles.isEmpty()){
+        if(mInterner != Q_NULLPTR){
+            removeObserver(mInterner);
+            delete mInterner;
+            mInterner = Q_NULLPTR;
+        }
+        return;
+    }
+    const QMetaObject* metaData = rowMetaObject();
+    if(metaData == Q_NULLPTR)
+        return;
+    QVector<int> properties;
+    for(const QString& role : roles){
+        const int j = metaData->indexOfProperty(role.toLatin1().constData());
+        if(j >= 0 && metaData->property(j).userType() == QMetaType::QString)
+            properties.append(j);
+        else
+            qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Not a QString role."<<role;
+    }
+    if(mInterner == Q_NULLPTR){
+        mInterner = new QmlListStringInterner(this);
+        mObservers.prepend(mInterner);
+    }
+    mInterner->setProperties(properties);
+    if(rowCount(QModelIndex()) > 0)
+        mInterner->rowsInserted(0, rowCount(QModelIndex()) - 1);
+}
+
+inline QStringList QAbstractBase::internedRoles() const
+{
+    QStringList roles;
+    if(mInterner == Q_NULLPTR || rowMetaObject() == Q_NULLPTR)
+        return roles;
+    for(int property : mInterner->properties())
+        roles.append(QString::fromLatin1(rowMetaObject()->property(property).name()));
+    return roles;
+}
+
+inline const QmlListStringPool* QAbstractBase::stringPool(const QString &role) const
+{
+    if(mInterner == Q_NULLPTR || rowMetaObject() == Q_NULLPTR)
+        return Q_NULLPTR;
+    return mInterner->pool(rowMetaObject()->indexOfProperty(role.toLatin1().constData()));
+}
+
+inline int QAbstractBase::squeezeStringPools()
+{
+    return mInterner == Q_NULLPTR ? 0 : mInterner->squeeze();
+}
+
+inline QmlListAggregate* QAbstractBase::aggregate_(const QString &role, const QString &operation)
+{
+    const QString& key = role + QLatin1Char(':') + operation.toLower();
+    QmlListAggregate* aggregate = mAggregates.value(key, Q_NULLPTR);
+    if(aggregate != Q_NULLPTR)
+        return aggregate;
+    bool ok;
+    const QmlListAggregate::Operation o = QmlListAggregate::operationFromString(operation, &ok);
+    const int property = rowMetaObject() == Q_NULLPTR ? -1 : rowMetaObject()->indexOfProperty(role.toLatin1().constData());
+    if(!ok || property < 0){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong aggregate."<<role<<operation;
+        return Q_NULLPTR;
+    }
+    aggregate = new QmlListAggregate(this, property, o, this);
+    QQmlEngine::setObjectOwnership(aggregate, QQmlEngine::CppOwnership);
+    addObserver(aggregate);
+    mAggregates.insert(key, aggregate);
+    return aggregate;
+}
+
+inline QAbstractBase::QAbstractBase(QObject *parent):
+    QAbstractListModel(parent)
+{
+#if UsingStats
+    /**
+      * Created up front, data() may be called from the worker threads of a parallel pass
+      */
+    mStats = new QmlListModelStats(this);
+    QQmlEngine::setObjectOwnership(mStats, QQmlEngine::CppOwnership);
+    addObserver(mStats);
+#endif
+}
+
+inline QAbstractBase::~QAbstractBase()
+{
+    /**
+      * The aggregates observe this model, delete them before the QObject children
+      */
+    for(QmlListAggregate* aggregate : mAggregates){
+        removeObserver(aggregate);
+        delete aggregate;
+    }
+#if UsingStats
+    if(mStats != Q_NULLPTR)
+        removeObserver(mStats);
+#endif
+    if(mSnapshotTracker != Q_NULLPTR){
+        removeObserver(mSnapshotTracker);
+        delete mSnapshotTracker;
+    }
+    clearViewport();
+    setInternedRoles(QStringList());
+#if UsingSerialize
+    setPatchRecording(false);
+#endif
+}
+
+inline QmlListMemoryUsage QAbstractBase::memoryUsage(int sampleRows) const
+{
+    QmlListMemoryUsage usage;
+    const QMetaObject* metaData = rowMetaObject();
+    const int count = rowCount(QModelIndex());
+    usage.rows = count;
+    usage.storage = qint64(sizeof(QListData::Data)) + count * qint64(sizeof(void*));
+    if(metaData == Q_NULLPTR)
+        return usage;
+    const qint64 objectBytes = rowSize() + QmlListMemoryUsage::ObjectPrivateBytes;
+    usage.objects = count * objectBytes;
+    const int step = sampleRows <= 0 || count <= sampleRows ? 1 : count / sampleRows;
+    qint64 payload = 0, nested = 0;
+    for(int i = 0; i < count; i += step){
+        const QObject* obj = rowObject(i);
+        if(obj == Q_NULLPTR)
+            continue;
+        ++usage.sampledRows;
+        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j){
+            const QMetaProperty& p = metaData->property(j);
+            if(mInterner != Q_NULLPTR && mInterner->pool(j) != Q_NULLPTR)
+                continue;
+            if(isSubList(p)){
+                const QAbstractBase* list = subList(p, obj);
+                if(list != Q_NULLPTR)
+                    nested += list->memoryUsage(sampleRows).total() + sizeof(QAbstractBase) + QmlListMemoryUsage::ObjectPrivateBytes;
+            } else {
+                payload += QmlListMemoryUsage::valueBytes(p.read(obj));
+            }
+        }
+    }
+    if(usage.sampledRows > 0){
+        usage.payload = payload * count / usage.sampledRows;
+        usage.nested = nested * count / usage.sampledRows;
+    }
+    if(mInterner != Q_NULLPTR)
+        usage.interned = mInterner->bytes();
+    /**
+      * The pending rows are costed as average rows
+      */
+    usage.pendingDeletes = mPendingDeletes * objectBytes;
+    if(usage.sampledRows > 0)
+        usage.pendingDeletes += mPendingDeletes * (payload + nested) / usage.sampledRows;
+    return usage;
+}
+
+inline QmlListModelSnapshot QAbstractBase::snapshot()
+{
+    if(mSnapshotTracker != Q_NULLPTR)
+        return mSnapshotTracker->snapshot();
+    if(rowMetaObject() == Q_NULLPTR)
+        return QmlListModelSnapshot();
+    QmlListModelSnapshotTracker once(this, false);
+    return once.snapshot();
+}
+
+inline void QAbstractBase::setSnapshotTracking(bool tracking)
+{
+    if(tracking == isSnapshotTracking() || (tracking && rowMetaObject() == Q_NULLPTR))
+        return;
+    if(tracking){
+        mSnapshotTracker = new QmlListModelSnapshotTracker(this);
+        addObserver(mSnapshotTracker);
+    } else {
+        removeObserver(mSnapshotTracker);
+        delete mSnapshotTracker;
+        mSnapshotTracker = Q_NULLPTR;
+    }
+}
+
+/**
+ * @brief The QmlListRole class describes a role by the member it is stored in,
+ * so C++ code can read and write the rows typed, bypassing QVariant and the meta object.
+ * Declare the roles by QML_LIST_ROLE.
+ */
+template<typename T, typename V, V T::*Member>
+struct QmlListRole
+{
+    typedef T Row;
+    typedef V Type;
+
+    static inline const V& get(const T* t){
+        return t->*Member;
+    }
+
+    static inline V& ref(T* t){
+        return t->*Member;
+    }
+};
+
+struct QmlListRoleLookup
+{
+    static inline int indexOf(const QMetaObject& metaObject, const char* property){
+        const int r = metaObject.indexOfProperty(property);
+        if(r < 0)
+            qDebug()<<"QmlListRole"<<__FUNCTION__<<"Error: Wrong role."<<metaObject.className()<<property;
+        return r;
+    }
+};
+
+/**
+  * Declares the role Name of the Q_PROPERTY Property stored in Class::Member, e.g.
+  * QML_LIST_ROLE(MemberNameRole, Member, mName, memberName);
+  * The role id is looked up once, -1 for a property Class does not declare.
+  */
+#define QML_LIST_ROLE(Name, Class, Member, Property) \
+struct Name : public QmlListRole<Class, decltype(Class::Member), &Class::Member> { \
+    static inline int role(){ \
+        static const int r = QmlListRoleLookup::indexOf(Class::staticMetaObject, #Property); \
+        return r; \
+    } \
+}
+
+/**
+ * @brief The QmlListColumn class iterates the values of one role, typed.
+ * It refers to the rows of the model and is invalidated by any insertion or removal.
+ */
+template<typename T, typename Role>
+class QmlListColumn
+{
+public:
+    typedef typename Role::Type Type;
+
+    class const_iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef typename Role::Type value_type;
+        typedef int difference_type;
+        typedef const value_type* pointer;
+        typedef const value_type& reference;
+
+        inline explicit const_iterator(typename QList<T*>::const_iterator i):
+            mI(i){}
+
+        inline const Type& operator*() const { return Role::get(*mI); }
+        inline const Type* operator->() const { return &Role::get(*mI); }
+        inline const_iterator& operator++(){ ++mI; return *this; }
+        inline const_iterator operator++(int){ const_iterator i(*this); ++mI; return i; }
+        inline const_iterator& operator--(){ --mI; return *this; }
+        inline const_iterator operator--(int){ const_iterator i(*this); --mI; return i; }
+        inline const_iterator& operator+=(int n){ mI += n; return *this; }
+        inline const_iterator& operator-=(int n){ mI -= n; return *this; }
+        inline const_iterator operator+(int n) const { return const_iterator(mI + n); }
+        inline const_iterator operator-(int n) const { return const_iterator(mI - n); }
+        friend inline const_iterator operator+(int n, const const_iterator& i){ return i + n; }
+        inline int operator-(const const_iterator& o) const { return int(mI - o.mI); }
+        inline const Type& operator[](int n) const { return Role::get(*(mI + n)); }
+        inline bool operator==(const const_iterator& o) const { return mI == o.mI; }
+        inline bool operator!=(const const_iterator& o) const { return mI != o.mI; }
+        inline bool operator<(const const_iterator& o) const { return mI < o.mI; }
+        inline bool operator>(const const_iterator& o) const { return mI > o.mI; }
+        inline bool operator<=(const const_iterator& o) const { return mI <= o.mI; }
+        inline bool operator>=(const const_iterator& o) const { return mI >= o.mI; }
+
+    private:
+        typename QList<T*>::const_iterator mI;
+    };
+
+    inline explicit QmlListColumn(const QList<T*>& data):
+        mData(data){}
+
+    inline int size() const {
+        return mData.size();
+    }
+
+    inline const Type& at(int i) const {
+        return Role::get(mData.at(i));
     }
 
-    virtual void unserialize(QByteArray data) {
-        Q_UNUSED(data);
+    inline const Type& operator[](int i) const {
+        return at(i);
     }
-#endif
 
-#if UsingJson
-    virtual QJsonArray toJson(){
-        return QJsonArray();
+    inline const_iterator begin() const {
+        return const_iterator(mData.constBegin());
     }
 
-    virtual bool fromJson(QJsonArray array){
-        Q_UNUSED(array);
-        return false;
+    inline const_iterator end() const {
+        return const_iterator(mData.constEnd());
     }
 
-    virtual bool jsonToObj(const QJsonValue &jsonValue, QObject *obj){
-        Q_UNUSED(jsonValue);
-        Q_UNUSED(obj);
-        return false;
+    inline QVector<Type> toVector() const {
+        QVector<Type> values;
+        values.reserve(mData.size());
+        for(const T* t : mData)
+            values.append(Role::get(t));
+        return values;
     }
-#endif
+
+private:
+    const QList<T*>& mData;
 };
 
 /**
@@ -75,6 +2862,14 @@ public:
   * The data operation directly manipulates the pointer of object.
   */
 #define QML_LIST_MODEL \
+    QML_LIST_MODEL_API \
+    Q_INVOKABLE inline QmlListAggregate* aggregate(QString role, QString operation){return aggregate_(role, operation);} \
+    QML_LIST_MODEL_STATS
+
+/**
+  * The part of QML_LIST_MODEL that any row storage provides, without the aggregates and the stats of QObject rows.
+  */
+#define QML_LIST_MODEL_API \
 public: \
     Q_INVOKABLE inline static QVariant create(){return create_();} \
     Q_INVOKABLE inline QVariant get(int i){return get_(i);} \
@@ -83,7 +2878,13 @@ public: \
     Q_INVOKABLE inline bool set(int i, QVariant data){return set_(i, data);} \
     Q_INVOKABLE inline int size(){return mData.size(); } \
     Q_INVOKABLE inline bool isEmpty(){return mData.isEmpty(); } \
-    Q_INVOKABLE inline bool remove(int i){return removeData(i);}
+    Q_INVOKABLE inline bool remove(int i){return removeData(i);} \
+    Q_INVOKABLE inline bool move(int from, int to, int count = 1){return moveData(from, to, count);} \
+    Q_INVOKABLE inline bool share(int i, QObject* other, int j = -1){return share_(i, other, j);} \
+    Q_INVOKABLE inline void setViewport(int first, int last, QStringList roles = QStringList()){setViewport_(first, last, roles);} \
+    Q_INVOKABLE inline QVariantList getRange(int from, int count, QStringList roles = QStringList()){return getRange_(from, count, roles);} \
+    Q_INVOKABLE inline QVariantList column(QString role){return column_(role);} \
+    Q_INVOKABLE inline void forEach(QJSValue callback){forEach_(callback);}
 
 template<typename T>
 /**
@@ -146,6 +2947,81 @@ public:
         data->toBytes(s);
         return s;
     }
+
+    void fromBytes(QDataStream& s) override;
+
+    void toBytes(QDataStream& s) override;
+
+    /**
+     * @brief toBytesParallel writes the same bytes as toBytes from a snapshot,
+     * serializing the chunks of rows concurrently. Without snapshot tracking
+     * the snapshot first reads the rows on the model thread.
+     * @param s
+     * @param threads
+     */
+    inline void toBytesParallel(QDataStream& s, int threads = QThread::idealThreadCount()){
+        QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::ToBytes));
+        snapshot().toBytes(s, threads);
+    }
+
+    /**
+     * @brief toBytesFramed writes the length-prefixed chunk format read by fromBytesFramed
+     * @param s
+     * @param threads
+     */
+    inline void toBytesFramed(QDataStream& s, int threads = QThread::idealThreadCount()){
+        QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::ToBytes));
+        snapshot().toBytesFramed(s, threads);
+    }
+
+    /**
+     * @brief fromBytesFramed indexes the chunk boundaries, decodes the chunks concurrently
+     * into pre-sized row storage, then replaces the rows by one bulk insert.
+     * @param s
+     * @param threads
+     * @return the result of converion
+     */
+    bool fromBytesFramed(QDataStream& s, int threads = QThread::idealThreadCount());
+
+    /**
+     * @brief toBytesSchema writes the rows column by column behind a schema of the property names,
+     * so the data stays readable after properties are added, removed or reordered.
+     * Format: magic, version, row count, field count, (name, type name, kind) per field,
+     * then per field its byte length and its column. QString columns are stored as
+     * little endian UTF-16 in one 8 bytes aligned block behind the offsets of the rows,
+     * nested list models as 8 bytes aligned schema blobs.
+     * @return
+     */
+    QByteArray toBytesSchema() override;
+
+    /**
+     * @brief fromBytesSchema maps the fields by name once, skips the unknown fields
+     * and leaves the missing properties to their default value.
+     * @param data The toBytesSchema bytes, e.g. QByteArray::fromRawData over QFile::map
+     * @param adoptStrings Adopt the QString columns by QString::fromRawData instead of copying them.
+     * The strings then point into data, which must stay alive and unchanged while any of them is used.
+     * The model keeps a reference to data until it is cleared or loads other data, and then until
+     * the removed rows are deleted by the event loop. The snapshots, the string pools and the rows
+     * kept by another model of shareData() copy the strings. Memory data only wraps, e.g. by
+     * QByteArray::fromRawData, is not kept by the reference: release it after the event loop ran,
+     * and keep it while the caller holds strings read from the rows.
+     * @return the result of converion
+     */
+    bool fromBytesSchema(const QByteArray& data, bool adoptStrings = false) override;
+
+    bool adoptsStrings() const override {
+        return !mSchemaBuffer.isNull();
+    }
+
+    /**
+     * @brief applyPatch replays a takePatch() of the source model, one insertion, removal,
+     * move or dataChanged per operation, a nested model is replaced by clear() and appendData().
+     * The patch must start at patchRevision() and is checked whole before the first operation,
+     * otherwise nothing is applied and the mirror has to be copied again.
+     * @param patch
+     * @return the result of applying
+     */
+    bool applyPatch(const QByteArray& patch);
 #endif
 
 #if UsingJson
@@ -153,10 +3029,6 @@ public:
         fromJson(jsonArray);
     }
 
-    void fromBytes(QDataStream& s) override;
-
-    void toBytes(QDataStream& s) override;
-
     /**
      * @brief toJson
      * @return Json array
@@ -198,6 +3070,35 @@ public:
      * @return the result of converion
      */
     bool fromJson(QJsonArray array) override;
+
+    /**
+     * @brief toJsonParallel converts a snapshot, the chunks of rows concurrently
+     * @param threads
+     * @return The same array as toJson
+     */
+    inline QJsonArray toJsonParallel(int threads = QThread::idealThreadCount()){
+        QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::ToJson));
+        return snapshot().toJson(threads);
+    }
+
+    /**
+     * @brief toJsonCompactParallel
+     * @param threads
+     * @return The same bytes as toJsonDoc().toJson(QJsonDocument::Compact)
+     */
+    inline QByteArray toJsonCompactParallel(int threads = QThread::idealThreadCount()){
+        QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::ToJson));
+        return snapshot().toJsonCompact(threads);
+    }
+
+    /**
+     * @brief fromJsonParallel constructs the rows concurrently, then replaces the rows
+     * by one bulk insert. Unlike fromJson the existing rows are not reused.
+     * @param array Json array
+     * @param threads
+     * @return the result of converion
+     */
+    bool fromJsonParallel(QJsonArray array, int threads = QThread::idealThreadCount());
 #endif
     /**
      * @brief clear
@@ -228,11 +3129,50 @@ public:
 
     static T* cloneData(const T* data);
 
+    QObject* rowObject(int i) const override {
+        return (i < 0 || i >= mData.count()) ? Q_NULLPTR : mData[i];
+    }
+
+    int rowIndex(const QObject* obj) const override {
+        const T* t = qobject_cast<const T*>(obj);
+        return t == Q_NULLPTR ? -1 : mData.indexOf(const_cast<T*>(t));
+    }
+
+    const QMetaObject* rowMetaObject() const override {
+        return &T::staticMetaObject;
+    }
+
+    int rowSize() const override {
+        return int(sizeof(T));
+    }
+
+    QObject* newRow() const override {
+        return new T;
+    }
+
+    void rowsChangedElsewhere(int first, int last, const QVector<int>& roles) override {
+        notifyDataChanged(first, last, roles);
+    }
+
+    void appendRows(const QList<QObject*>& rows) override {
+        QList<T*> data;
+        data.reserve(rows.size());
+        for(QObject* obj : rows)
+            data.append(static_cast<T*>(obj));
+        appendData(data);
+    }
+
     /**
      * @brief appendData
      * @param data
      */
     void appendData(T *data);
+
+    /**
+     * @brief appendData appends the rows by one insertion
+     * @param data
+     */
+    void appendData(const QList<T*>& data);
     /**
      * @brief getData
      * @param i
@@ -246,6 +3186,14 @@ public:
      * @return
      */
     bool insertData(int i, T* data);
+
+    /**
+     * @brief insertData inserts the rows by one insertion
+     * @param i
+     * @param data
+     * @return
+     */
+    bool insertData(int i, const QList<T*>& data);
     /**
      * @brief setData
      * @param i
@@ -261,6 +3209,153 @@ public:
      */
     bool removeData(int i);
 
+    /**
+     * @brief removeData removes count rows from first by one removal
+     * @param first
+     * @param count
+     * @return
+     */
+    bool removeData(int first, int count);
+
+    /**
+     * @brief shareData inserts row i into other without copying it. The row is deleted
+     * when the last model holding it removes it, and its changes made through
+     * either model are notified by both.
+     * @param i
+     * @param other
+     * @param j The row in other, -1 to append
+     * @return
+     */
+    bool shareData(int i, QmlListModel<T>* other, int j = -1);
+
+    /**
+     * @brief moveData moves count rows from from so that the first of them lands at to,
+     * the rows and their delegates are kept
+     * @param from
+     * @param to Index of the first moved row after the move
+     * @param count
+     * @return
+     */
+    bool moveData(int from, int to, int count = 1);
+
+    /**
+     * @brief setWindow keeps at most capacity rows, the rows appended by appendWindowed()
+     * evict the oldest ones
+     * @param capacity 0 for no limit
+     */
+    void setWindow(int capacity);
+
+    inline int window() const {
+        return mWindow;
+    }
+
+    /**
+     * @brief appendWindowed queues a row for the tail. The queued rows are inserted and the
+     * oldest rows evicted by one removal and one insertion when the event loop runs or
+     * on flushWindow(). The evicted rows are kept for recycledRow() instead of being deleted.
+     * @param data
+     */
+    void appendWindowed(T* data);
+
+    /**
+     * @brief flushWindow inserts the queued rows now
+     */
+    void flushWindow();
+
+    /**
+     * @brief recycledRow
+     * @return A row evicted earlier, to be refilled and appended again, or a new row
+     */
+    inline T* recycledRow(){
+        return mRecycled.isEmpty() ? new T : mRecycled.takeLast();
+    }
+
+    /**
+     * @brief value reads a role typed, i must be valid
+     * @param i
+     * @return
+     */
+    template<typename Role>
+    inline const typename Role::Type& value(int i) const {
+        Q_ASSERT(i >= 0 && i < mData.count());
+        return Role::get(mData.at(i));
+    }
+
+    /**
+     * @brief setValue writes a role typed and notifies only that role.
+     * A role with a NOTIFY signal is written through its property, so the bindings on the row
+     * are updated; a role without one is written to its member, bypassing any WRITE setter.
+     * @param i
+     * @param v
+     * @return
+     */
+    template<typename Role>
+    bool setValue(int i, const typename Role::Type& v);
+
+    /**
+     * @brief setValues writes a role of the rows from first on, notified as one range,
+     * each row as by setValue
+     * @param first
+     * @param values
+     * @return
+     */
+    template<typename Role>
+    bool setValues(int first, const QVector<typename Role::Type>& values);
+
+    /**
+     * @brief values
+     * @return Typed iterable view of one role
+     */
+    template<typename Role>
+    inline QmlListColumn<T, Role> values() const {
+        return QmlListColumn<T, Role>(mData);
+    }
+
+    /**
+     * @brief setUpdateThrottle coalesces dataChanged notifications.
+     * Dirty rows and roles are accumulated and flushed as merged contiguous ranges.
+     * @param maxRate Maximum flushes per second, 0 disables throttling,
+     * a negative value only flushes on flushUpdates(), e.g. connected to QQuickWindow::frameSwapped
+     */
+    void setUpdateThrottle(int maxRate);
+
+    /**
+     * @brief updateThrottle
+     * @return Maximum flushes per second
+     */
+    inline int updateThrottle() const {
+        return mThrottleRate;
+    }
+
+    /**
+     * @brief flushUpdates emits the pending dirty rows
+     */
+    void flushUpdates();
+
+    /**
+     * @brief updatesReceived
+     * @return Count of row changes requested since the last resetUpdateStats()
+     */
+    inline quint64 updatesReceived() const {
+        return mUpdatesReceived;
+    }
+
+    /**
+     * @brief updatesEmitted
+     * @return Count of dataChanged signals emitted since the last resetUpdateStats()
+     */
+    inline quint64 updatesEmitted() const {
+        return mUpdatesEmitted;
+    }
+
+    /**
+     * @brief resetUpdateStats
+     */
+    inline void resetUpdateStats(){
+        mUpdatesReceived = 0;
+        mUpdatesEmitted = 0;
+    }
+
 signals:
 
 public slots:
@@ -272,6 +3367,47 @@ protected:
      */
     static QVariant create_();
 
+#if UsingSerialize
+    /**
+     * @brief readRow reads the properties of one row in the toBytes encoding
+     * @param s
+     * @param t
+     */
+    static void readRow(QDataStream& s, T* t);
+
+    /**
+     * @brief copyProperty copies one property of from over to, a nested model through its toBytes
+     * so the nested model of to is reset by clear() and appendData()
+     */
+    static inline void copyProperty(const QMetaProperty& p, T* from, T* to, int version){
+        if(!isSubList(p)){
+            p.write(to, p.read(from));
+            return;
+        }
+        QAbstractBase* destination = subList(p, to);
+        if(destination == Q_NULLPTR)
+            return;
+        QByteArray bytes;
+        QDataStream w(&bytes, QIODevice::WriteOnly);
+        w.setVersion(version);
+        writeProperty(w, p, from);
+        QDataStream r(bytes);
+        r.setVersion(version);
+        destination->fromBytes(r);
+    }
+#endif
+
+    /**
+     * @brief releaseRows deletes the rows which were not inserted
+     * @param rows
+     */
+    static inline void releaseRows(const QVector<T*>& rows){
+        for(T* t : rows){
+            if(t != Q_NULLPTR)
+                t->deleteLater();
+        }
+    }
+
     /**
      * @brief append_
      * @param data
@@ -285,8 +3421,19 @@ protected:
      * @return
      */
     inline QVariant get_(int i){
+        QML_LIST_STATS(stats()->getCalled());
         return QVariant::fromValue<T*>(getData(i));
     }
+    /**
+     * @brief share_
+     * @param i
+     * @param other A model of the same row type
+     * @param j
+     * @return
+     */
+    inline bool share_(int i, QObject* other, int j){
+        return shareData(i, dynamic_cast<QmlListModel<T>*>(other), j);
+    }
     /**
      * @brief insert_
      * @param i
@@ -306,16 +3453,113 @@ protected:
         return setData(i, data.value<T*>());
     }
 
+    /**
+     * @brief getRange_
+     * @param from
+     * @param count
+     * @param roles Role names, empty for all
+     * @return Rows as objects of the requested roles
+     */
+    QVariantList getRange_(int from, int count, const QStringList& roles) const;
+
+    /**
+     * @brief writeRole writes the member of a role, through its property when it has a NOTIFY signal
+     * @param t
+     * @param v
+     */
+    template<typename Role>
+    static inline void writeRole(T* t, const typename Role::Type& v){
+        static const int property = Role::role();
+        static const bool notify = property >= 0 && T::staticMetaObject.property(property).hasNotifySignal();
+        if(notify)
+            T::staticMetaObject.property(property).write(t, QVariant::fromValue(v));
+        else
+            Role::ref(t) = v;
+    }
+
+    /**
+     * @brief column_
+     * @param role Role name
+     * @return Values of one role
+     */
+    QVariantList column_(const QString& role) const;
+
+    /**
+     * @brief forEach_ calls callback(row, index) for every row until it returns false
+     * @param callback
+     */
+    void forEach_(QJSValue callback);
+
     /**
      * @brief roleNames
      * @return
      */
     QHash<int, QByteArray> roleNames() const override;
+
+    /**
+     * @brief notifyDataChanged emits dataChanged, or marks the rows dirty when throttled
+     * @param first
+     * @param last
+     * @param roles Changed roles, empty for all
+     */
+    void notifyDataChanged(int first, int last, const QVector<int>& roles = QVector<int>());
+
     /**
      * @brief Data list
      */
     QList<T*> mData;
 
+private:
+#if UsingSerialize
+    /**
+      * Buffer the adopted strings of fromBytesSchema point into
+      */
+    QByteArray          mSchemaBuffer;
+
+    static inline void schemaAlign(QDataStream& s){
+        static const char zeros[8] = {0};
+        const qint64 pad = (8 - s.device()->pos() % 8) % 8;
+        if(s.device()->isWritable())
+            s.writeRawData(zeros, int(pad));
+        else
+            s.skipRawData(int(pad));
+    }
+#endif
+
+    /**
+      * Update throttle
+      */
+    int         mThrottleRate       = 0;
+    QTimer*     mThrottleTimer      = Q_NULLPTR;
+    QBitArray   mDirtyRows;
+    QBitArray   mDirtyRoles;
+    bool        mDirtyAllRoles      = false;
+    int         mDirtyFirst         = -1;
+    int         mDirtyLast          = -1;
+    quint64     mUpdatesReceived    = 0;
+    quint64     mUpdatesEmitted     = 0;
+
+    /**
+      * Window of the appended stream
+      */
+    int         mWindow             = 0;
+    bool        mWindowFlushQueued  = false;
+    QList<T*>   mWindowQueue;
+    QVector<T*> mRecycled;
+
+    /**
+     * @brief recycle keeps an evicted row for recycledRow(), up to a window of rows
+     * @param t
+     */
+    inline void recycle(T* t){
+        if(t == Q_NULLPTR)
+            return;
+        if(mRecycled.size() >= qMax(mWindow, 1) || QmlListRowRegistry::contains(t)){
+            releaseLater(t);
+            return;
+        }
+        mRecycled.append(t);
+    }
 };
 
 /**
@@ -331,59 +3575,521 @@ template<typename T>
 QmlListModel<T>::~QmlListModel()
 {
     clear();
+    qDeleteAll(mWindowQueue);
+    qDeleteAll(mRecycled);
+}
+
+#if UsingSerialize
+template<typename T>
+void QmlListModel<T>::toBytes(QDataStream &s)
+{
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::ToBytes));
+    const QList<T*>& l = mData;
+    s << quint32(l.size());
+    for (int i = 0; i < l.size(); ++i)
+        writeRow(s, l.at(i));
+}
+
+template<typename T>
+void QmlListModel<T>::fromBytes(QDataStream &s)
+{
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::FromBytes));
+    quint32 c;
+    s >> c;
+    /**
+      * The rows replace the current ones through clear() and appendData(), so the views
+      * and observers of a nested model follow
+      */
+    QList<T*> rows;
+    if(s.device() != Q_NULLPTR)
+        rows.reserve(int(qMin<qint64>(c, s.device()->bytesAvailable())));
+    for(quint32 i = 0; i < c && s.status() == QDataStream::Ok; ++i) {
+        T* t = new T;
+        readRow(s, t);
+        rows.append(t);
+        if (s.atEnd())
+            break;
+    }
+    clear();
+    appendData(rows);
+}
+
+template<typename T>
+void QmlListModel<T>::readRow(QDataStream &s, T *t)
+{
+    const QMetaObject* metaData = t->metaObject();
+    for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j) {
+        const QMetaProperty& p = metaData->property(j);
+        if(QString(p.typeName()).endsWith('*')){
+            QmlListModel* subList = reinterpret_cast<QmlListModel*>(qvariant_cast<QObject *>(p.read(t)));
+            if(subList != Q_NULLPTR){
+                s >> subList;
+            } else {
+                /**
+                  * A null nested model is written as an empty one, rows for it cannot be read
+                  */
+                quint32 c;
+                s >> c;
+                if(c != 0){
+                    qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Null property."<<p.name();
+                    s.setStatus(QDataStream::ReadCorruptData);
+                }
+            }
+        } else {
+            QVariant v;
+            s >> v;
+            p.write(t, v);
+        }
+    }
+}
+
+template<typename T>
+bool QmlListModel<T>::fromBytesFramed(QDataStream &s, int threads)
+{
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::FromBytes));
+    quint32 magic, rowCount, chunkCount;
+    s >> magic >> rowCount >> chunkCount;
+    if(s.status() != QDataStream::Ok || magic != QmlListModelSnapshot::FramedMagic){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong format.";
+        return false;
+    }
+    /**
+      * Index the chunk boundaries, nothing is allocated beyond what the device holds:
+      * a chunk header takes 8 bytes, and a row of at least one property 1 byte or more
+      */
+    qint64 available = s.device() == Q_NULLPTR ? 0 : s.device()->bytesAvailable();
+    if(qint64(chunkCount) > available / 8){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Truncated data.";
+        return false;
+    }
+    available -= qint64(chunkCount) * 8;
+    const bool hasProperties = T::staticMetaObject.propertyCount() > T::staticMetaObject.propertyOffset();
+    QVector<quint32> firstRows(int(chunkCount)), chunkRows(int(chunkCount)), chunkBytes(int(chunkCount));
+    quint32 total = 0;
+    for(quint32 k = 0; k < chunkCount; ++k){
+        s >> chunkRows[k] >> chunkBytes[k];
+        if(s.status() != QDataStream::Ok || qint64(chunkBytes.at(k)) > available
+                || chunkRows.at(k) > rowCount - total || (hasProperties && chunkRows.at(k) > chunkBytes.at(k))){
+            qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Truncated data.";
+            return false;
+        }
+        available -= chunkBytes.at(k);
+        firstRows[k] = total;
+        total += chunkRows.at(k);
+    }
+    if(total != rowCount){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Truncated data.";
+        return false;
+    }
+    QVector<QByteArray> parts(int(chunkCount));
+    for(quint32 k = 0; k < chunkCount && s.status() == QDataStream::Ok; ++k){
+        parts[k].resize(int(chunkBytes.at(k)));
+        if(s.readRawData(parts[k].data(), parts[k].size()) != parts[k].size())
+            s.setStatus(QDataStream::ReadPastEnd);
+    }
+    if(s.status() != QDataStream::Ok){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Truncated data.";
+        return false;
+    }
+    /**
+      * Decode the chunks into pre-sized storage, the rows are constructed
+      * on the worker threads and moved to the model thread
+      */
+    QVector<T*> rows(int(rowCount), Q_NULLPTR);
+    QAtomicInt failed(0);
+    QThread* modelThread = thread();
+    const int version = s.version();
+    const QDataStream::ByteOrder byteOrder = s.byteOrder();
+    const QDataStream::FloatingPointPrecision precision = s.floatingPointPrecision();
+    QmlListModelParallel::run(int(chunkCount), threads, [&](int k){
+        QDataStream part(parts.at(k));
+        part.setVersion(version);
+        part.setByteOrder(byteOrder);
+        part.setFloatingPointPrecision(precision);
+        for(quint32 r = 0; r < chunkRows.at(k) && part.status() == QDataStream::Ok; ++r){
+            T* t = new T;
+            readRow(part, t);
+            moveRowToThread(t, modelThread);
+            rows[int(firstRows.at(k) + r)] = t;
+        }
+        if(part.status() != QDataStream::Ok)
+            failed.storeRelease(1);
+    });
+    if(failed.loadAcquire()){
+        releaseRows(rows);
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong chunk data.";
+        return false;
+    }
+    clear();
+    appendData(rows.toList());
+    return true;
 }
 
-#if UsingSerialize
 template<typename T>
-void QmlListModel<T>::toBytes(QDataStream &s)
+QByteArray QmlListModel<T>::toBytesSchema()
 {
-    const QList<T*>& l = mData;
-    s << quint32(l.size());
-    for (int i = 0; i < l.size(); ++i) {
-        T* t = l.at(i);
-        const QMetaObject* metaData = t->metaObject();
-        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j) {
-            const QMetaProperty& p = metaData->property(j);
-            const QVariant& v = p.read(t);
-            if(QString(p.typeName()).endsWith('*')){
-                s << reinterpret_cast<QmlListModel*>(qvariant_cast<QObject *>(p.read(t)));
-            } else {
-                s << v;
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::ToBytes));
+    QByteArray buffer;
+    QDataStream s(&buffer, QIODevice::WriteOnly);
+    const QMetaObject* metaData = &T::staticMetaObject;
+    const int count = mData.size();
+    s << quint32(SchemaMagic) << quint16(SchemaVersion) << quint32(count)
+      << quint16(metaData->propertyCount() - metaData->propertyOffset());
+    for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j) {
+        const QMetaProperty& p = metaData->property(j);
+        const quint8 kind = isSubList(p) ? SchemaNested : p.userType() == QMetaType::QString ? SchemaString : SchemaVariant;
+        s << QByteArray(p.name()) << QByteArray(p.typeName()) << kind;
+    }
+    for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j) {
+        const QMetaProperty& p = metaData->property(j);
+        /**
+          * The column length is patched once the column is written
+          */
+        const qint64 lengthPos = s.device()->pos();
+        s << quint64(0);
+        const qint64 begin = s.device()->pos();
+        if(isSubList(p)){
+            for(T* t : mData){
+                QAbstractBase* list = subList(p, t);
+                const QByteArray& nested = list == Q_NULLPTR ? QByteArray() : list->toBytesSchema();
+                s << quint32(nested.size());
+                schemaAlign(s);
+                s.writeRawData(nested.constData(), nested.size());
+            }
+        } else if(p.userType() == QMetaType::QString){
+            QVector<QString> values(count);
+            QVector<quint32> offsets(count + 1);
+            offsets[0] = 0;
+            for(int i = 0; i < count; ++i){
+                values[i] = p.read(mData.at(i)).toString();
+                offsets[i + 1] = offsets.at(i) + quint32(values.at(i).size());
             }
+            for(quint32& o : offsets)
+                o = qToLittleEndian(o);
+            s.writeRawData(reinterpret_cast<const char*>(offsets.constData()), offsets.size() * int(sizeof(quint32)));
+            schemaAlign(s);
+            for(const QString& v : values){
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+                s.writeRawData(reinterpret_cast<const char*>(v.utf16()), v.size() * int(sizeof(QChar)));
+#else
+                for(const QChar& c : v){
+                    const quint16 u = qToLittleEndian(c.unicode());
+                    s.writeRawData(reinterpret_cast<const char*>(&u), int(sizeof(u)));
+                }
+#endif
+            }
+        } else {
+            for(T* t : mData)
+                s << p.read(t);
         }
+        const qint64 end = s.device()->pos();
+        s.device()->seek(lengthPos);
+        s << quint64(end - begin);
+        s.device()->seek(end);
     }
+    return buffer;
 }
 
 template<typename T>
-void QmlListModel<T>::fromBytes(QDataStream &s)
+bool QmlListModel<T>::fromBytesSchema(const QByteArray& data, bool adoptStrings)
 {
-    QList<T*>& l = this->mData;
-    l.clear();
-    quint32 c;
-    s >> c;
-    l.reserve(c);
-    for(quint32 i = 0; i < c; ++i) {
-        T* t = new T;
-        const QMetaObject* metaData = t->metaObject();
-        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j) {
-            const QMetaProperty& p = metaData->property(j);
-            if(QString(p.typeName()).endsWith('*')){
-                QmlListModel* subList = reinterpret_cast<QmlListModel*>(qvariant_cast<QObject *>(p.read(t)));
-                if(subList != Q_NULLPTR)
-                    s >> subList;
-                else
-                    qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Null property.";
-                    //subList = new QmlListModel; // TBD
-            } else {
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::FromBytes));
+    QDataStream s(data);
+    quint32 magic, count;
+    quint16 version, fieldCount;
+    s >> magic >> version >> count >> fieldCount;
+    if(s.status() != QDataStream::Ok || magic != SchemaMagic || version > SchemaVersion){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong format.";
+        return false;
+    }
+    /**
+      * Map the fields by name once
+      */
+    const QMetaObject* metaData = &T::staticMetaObject;
+    QVector<int> properties(fieldCount, -1);
+    QVector<quint8> kinds(fieldCount);
+    for(int f = 0; f < fieldCount; ++f){
+        QByteArray name, typeName;
+        s >> name >> typeName >> kinds[f];
+        const int j = metaData->indexOfProperty(name.constData());
+        if(j < metaData->propertyOffset())
+            continue;
+        const QMetaProperty& p = metaData->property(j);
+        if(isSubList(p) != (kinds.at(f) == SchemaNested))
+            qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong property type."<<p.typeName()<<p.name()<<typeName;
+        else
+            properties[f] = j;
+    }
+    /**
+      * Every column holds 4 bytes or more per row, a row count beyond the payload is not allocated
+      */
+    const qint64 payload = data.size() - s.device()->pos();
+    if(s.status() != QDataStream::Ok || qint64(count) > (fieldCount == 0 ? payload : payload / 4)){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Truncated data.";
+        return false;
+    }
+    QVector<T*> rows(int(count), Q_NULLPTR);
+    for(T*& t : rows)
+        t = new T;
+    const char* base = data.constData();
+    bool ok = true;
+    for(int f = 0; f < fieldCount && ok; ++f){
+        quint64 length;
+        s >> length;
+        const qint64 begin = s.device()->pos();
+        if(s.status() != QDataStream::Ok || begin + qint64(length) > data.size()){
+            ok = false;
+            break;
+        }
+        if(properties.at(f) < 0){
+            s.skipRawData(int(length));
+            continue;
+        }
+        const QMetaProperty& p = metaData->property(properties.at(f));
+        if(kinds.at(f) == SchemaString){
+            const qint64 offsetsPos = begin;
+            const qint64 offsetsSize = (qint64(count) + 1) * qint64(sizeof(quint32));
+            if(offsetsSize > qint64(length)){
+                ok = false;
+                break;
+            }
+            s.skipRawData(int(offsetsSize));
+            schemaAlign(s);
+            const qint64 blobPos = s.device()->pos();
+            const qint64 blobSize = begin + qint64(length) - blobPos;
+            quint32 from = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(base + offsetsPos));
+            for(quint32 i = 0; i < count && ok; ++i){
+                const quint32 to = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(base + offsetsPos + (i + 1) * sizeof(quint32)));
+                if(to < from || qint64(to) * qint64(sizeof(QChar)) > blobSize){
+                    ok = false;
+                    break;
+                }
+                const QChar* chars = reinterpret_cast<const QChar*>(base + blobPos) + from;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+                const QString& v = adoptStrings ? QString::fromRawData(chars, int(to - from)) : QString(chars, int(to - from));
+#else
+                QString v(int(to - from), Qt::Uninitialized);
+                for(int c = 0; c < v.size(); ++c)
+                    v[c] = QChar(qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(chars + c)));
+#endif
+                p.write(rows.at(int(i)), v);
+                from = to;
+            }
+        } else if(kinds.at(f) == SchemaNested){
+            for(quint32 i = 0; i < count && ok; ++i){
+                quint32 size;
+                s >> size;
+                schemaAlign(s);
+                const qint64 pos = s.device()->pos();
+                QAbstractBase* list = subList(p, rows.at(int(i)));
+                if(s.status() != QDataStream::Ok || pos + size > begin + qint64(length)){
+                    ok = false;
+                } else if(size > 0){
+                    if(list != Q_NULLPTR)
+                        ok = list->fromBytesSchema(QByteArray::fromRawData(base + pos, int(size)), adoptStrings);
+                    else
+                        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Null property.";
+                }
+                s.skipRawData(int(size));
+            }
+        } else {
+            for(quint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i){
                 QVariant v;
                 s >> v;
-                p.write(t, v);
+                p.write(rows.at(int(i)), v);
             }
+            ok = s.status() == QDataStream::Ok;
         }
-        appendData(t);
-        if (s.atEnd())
+        /**
+          * The next field starts behind the column length, whatever the column reader consumed
+          */
+        s.device()->seek(begin + qint64(length));
+    }
+    if(!ok){
+        releaseRows(rows);
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong column data.";
+        return false;
+    }
+    clear();
+    /**
+      * A data wrapping foreign memory, e.g. by QByteArray::fromRawData, is not kept alive by this
+      */
+    if(adoptStrings)
+        mSchemaBuffer = data;
+    appendData(rows.toList());
+    return true;
+}
+
+template<typename T>
+bool QmlListModel<T>::applyPatch(const QByteArray& patch)
+{
+    QDataStream s(patch);
+    quint32 magic, baseRevision, revision, count;
+    s >> magic >> baseRevision >> revision >> count;
+    if(s.status() != QDataStream::Ok || magic != PatchMagic){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong format.";
+        return false;
+    }
+    if(baseRevision != patchRevision()){
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong revision."<<baseRevision<<patchRevision();
+        return false;
+    }
+    /**
+      * Decode and check the whole patch against the row counts it goes through,
+      * so a wrong patch leaves the model and its revision untouched
+      */
+    struct Operation {
+        quint8          operation;
+        quint32         first;
+        quint32         rows;
+        quint32         to;
+        QVector<int>    roles;
+        QVector<T*>     data;
+        QByteArray      nested;
+    };
+    const QMetaObject* metaData = &T::staticMetaObject;
+    QVector<Operation> operations;
+    operations.reserve(int(qMin<qint64>(count, patch.size())));
+    qint64 rowCount = mData.count();
+    for(quint32 k = 0; k < count && s.status() == QDataStream::Ok; ++k){
+        Operation o;
+        o.to = 0;
+        s >> o.operation >> o.first >> o.rows;
+        if(s.status() != QDataStream::Ok)
             break;
+        const qint64 first = o.first, rows = o.rows;
+        if(o.operation == PatchInsert){
+            if(first > rowCount || rows > patch.size()){
+                s.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            o.data.resize(int(rows));
+            for(T*& t : o.data){
+                t = new T;
+                readRow(s, t);
+            }
+            rowCount += rows;
+        } else if(o.operation == PatchRemove){
+            if(first + rows > rowCount)
+                s.setStatus(QDataStream::ReadCorruptData);
+            rowCount -= rows;
+        } else if(o.operation == PatchMove){
+            s >> o.to;
+            if(rows == 0 || first + rows > rowCount || qint64(o.to) + rows > rowCount)
+                s.setStatus(QDataStream::ReadCorruptData);
+        } else if(o.operation == PatchChange){
+            quint16 roleCount;
+            s >> roleCount;
+            o.roles.resize(roleCount);
+            for(int& r : o.roles){
+                quint16 role;
+                s >> role;
+                r = role;
+                if(r < metaData->propertyOffset() || r >= metaData->propertyCount())
+                    s.setStatus(QDataStream::ReadCorruptData);
+            }
+            if(s.status() != QDataStream::Ok || first + rows > rowCount){
+                s.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            /**
+              * The values are read into spare rows, copied over the model rows once all is read
+              */
+            o.data.resize(int(rows));
+            for(T*& t : o.data){
+                t = new T;
+                if(o.roles.isEmpty()){
+                    readRow(s, t);
+                    continue;
+                }
+                for(int r : o.roles){
+                    const QMetaProperty& p = metaData->property(r);
+                    if(isSubList(p)){
+                        QAbstractBase* list = subList(p, t);
+                        quint32 c = 0;
+                        if(list != Q_NULLPTR)
+                            list->fromBytes(s);
+                        else
+                            s >> c;
+                        if(c != 0)
+                            s.setStatus(QDataStream::ReadCorruptData);
+                    } else {
+                        QVariant v;
+                        s >> v;
+                        p.write(t, v);
+                    }
+                }
+            }
+        } else if(o.operation == PatchNested){
+            /**
+              * first is the owner row, rows the property of the nested model
+              */
+            s >> o.nested;
+            if(s.status() != QDataStream::Ok || first >= rowCount || rows < quint32(metaData->propertyOffset())
+                    || rows >= quint32(metaData->propertyCount()) || !isSubList(metaData->property(int(rows)))){
+                s.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            T* t = new T;
+            QAbstractBase* list = subList(metaData->property(int(rows)), t);
+            QDataStream n(o.nested);
+            n.setVersion(s.version());
+            if(list != Q_NULLPTR)
+                list->fromBytes(n);
+            if(list == Q_NULLPTR || n.status() != QDataStream::Ok)
+                s.setStatus(QDataStream::ReadCorruptData);
+            releaseRows(QVector<T*>(1, t));
+        } else {
+            s.setStatus(QDataStream::ReadCorruptData);
+        }
+        operations.append(o);
+    }
+    if(s.status() != QDataStream::Ok || operations.size() != int(count)){
+        for(const Operation& o : operations)
+            releaseRows(o.data);
+        qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong operation data.";
+        return false;
+    }
+    /**
+      * Apply, every operation has been checked
+      */
+    for(const Operation& o : operations){
+        const int first = int(o.first), rows = int(o.rows);
+        if(o.operation == PatchInsert){
+            insertData(first, o.data.toList());
+        } else if(o.operation == PatchRemove){
+            if(rows > 0)
+                removeData(first, rows);
+        } else if(o.operation == PatchMove){
+            moveData(first, int(o.to), rows);
+        } else if(o.operation == PatchChange){
+            if(rows > 0){
+                const int last = first + rows - 1;
+                QVector<int> properties = o.roles;
+                if(properties.isEmpty()){
+                    for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j)
+                        properties.append(j);
+                }
+                observeAboutToChange(first, last, o.roles);
+                for(int i = first; i <= last; ++i){
+                    for(int j : properties)
+                        copyProperty(metaData->property(j), o.data.at(i - first), mData.at(i), s.version());
+                }
+                notifyDataChanged(first, last, o.roles);
+            }
+            releaseRows(o.data);
+        } else if(o.operation == PatchNested){
+            QAbstractBase* list = subList(metaData->property(rows), mData.at(first));
+            QDataStream n(o.nested);
+            n.setVersion(s.version());
+            if(list != Q_NULLPTR)
+                list->fromBytes(n);
+            else
+                qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Null property.";
+        }
     }
+    setPatchRevision(revision);
+    return true;
 }
 #endif
 
@@ -391,6 +4097,7 @@ void QmlListModel<T>::fromBytes(QDataStream &s)
 template<typename T>
 QJsonArray QmlListModel<T>::toJson()
 {
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::ToJson));
     QJsonArray jsonArray;
     foreach (T* t, mData) {
         QJsonObject jsonObj;
@@ -406,25 +4113,12 @@ QJsonArray QmlListModel<T>::toJson()
                     jsonObj.insert(p.name(), QJsonValue());
                 }
             } else {
-                switch (p.type()) {
-                case QVariant::Bool:
-                    jsonObj.insert(p.name(), v.toBool());
-                    break;
-                case QVariant::Double:
-                    jsonObj.insert(p.name(), v.toDouble());
-                    break;
-                case QVariant::UInt:
-                case QVariant::Int:
-                    jsonObj.insert(p.name(), v.toInt());
-                    break;
-                case QVariant::Char:
-                case QVariant::String:
-                    jsonObj.insert(p.name(), v.toString());
-                    break;
-                default:
+                bool ok;
+                const QJsonValue& jsonValue = qmlListPropertyToJson(p.type(), v, &ok);
+                if(ok)
+                    jsonObj.insert(p.name(), jsonValue);
+                else
                     qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Wrong property."<<p.typeName()<<p.name()<<v;
-                    break;
-                }
             }
         }
         jsonArray.append(jsonObj);
@@ -477,22 +4171,28 @@ bool QmlListModel<T>::jsonToObj(const QJsonValue &jsonValue, QObject *obj)
 template<typename T>
 bool QmlListModel<T>::fromJson(QJsonArray array)
 {
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::FromJson));
     int i,
         mid = qMin(mData.size(), array.size()),
         max = qMax(mData.size(), array.size());
     /**
       * Replace the exists
       */
-    for(i = 0; i < mid; i++){
-        if(!jsonToObj(array.at(i), mData[i])){
-            return false;
-        }
+    bool replaced = true;
+    if(mid > 0)
+        observeAboutToChange(0, mid - 1, QVector<int>());
+    for(i = 0; i < mid && replaced; i++){
+        replaced = jsonToObj(array.at(i), mData[i]);
     }
+    if(mid > 0)
+        notifyDataChanged(0, mid - 1);
+    if(!replaced)
+        return false;
     if(array.size() < mData.size()){
         /**
           * Remove the out of bounds
           */
-        for(i = mid; i < max; i++){
+        for(i = max - 1; i >= mid; i--){
             if(!removeData(i)){
                 return false;
             }
@@ -513,22 +4213,89 @@ bool QmlListModel<T>::fromJson(QJsonArray array)
 }
 #endif
 
+#if UsingJson
+template<typename T>
+bool QmlListModel<T>::fromJsonParallel(QJsonArray array, int threads)
+{
+    QML_LIST_STATS(QmlListModelStats::Scope scope(stats(), QmlListModelStats::FromJson));
+    const int count = array.size(),
+              chunks = (count + 511) / 512;
+    QVector<T*> rows(count, Q_NULLPTR);
+    QAtomicInt failed(0);
+    QThread* modelThread = thread();
+    QmlListModelParallel::run(chunks, threads, [&](int k){
+        for(int i = k * 512; i < qMin(count, (k + 1) * 512) && !failed.loadAcquire(); ++i){
+            T* t = new T;
+            rows[i] = t;
+            if(!jsonToObj(array.at(i), t)){
+                failed.storeRelease(1);
+                qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error: Append failed."<<i<<T::staticMetaObject.className();
+            }
+            moveRowToThread(t, modelThread);
+        }
+    });
+    if(failed.loadAcquire()){
+        releaseRows(rows);
+        return false;
+    }
+    clear();
+    appendData(rows.toList());
+    return true;
+}
+#endif
+
 template<typename T>
 void QmlListModel<T>::clear()
 {
-    beginRemoveRows(QModelIndex(), 0, mData.size());
+    /**
+      * Pending updates refer to the rows being removed
+      */
+    mDirtyRows.fill(false);
+    mDirtyAllRoles = false;
+    mDirtyFirst = mDirtyLast = -1;
+    if(mData.isEmpty()){
+#if UsingSerialize
+        mSchemaBuffer.clear();
+#endif
+        return;
+    }
+    beginRemoveRows(QModelIndex(), 0, mData.size() - 1);
+    observeAboutToBeRemoved(0, mData.size() - 1);
+    const int last = mData.size() - 1;
     for(T* d : mData){
-        d->deleteLater();
+        releaseLater(d);
     }
     mData.clear();
+#if UsingSerialize
+    if(!mSchemaBuffer.isNull()){
+        /**
+          * The removed rows hold adopted strings until their deferred delete, the buffer is released behind it
+          */
+        const QByteArray buffer = mSchemaBuffer;
+        QMetaObject::invokeMethod(this, [buffer](){
+            Q_UNUSED(buffer)
+        }, Qt::QueuedConnection);
+        mSchemaBuffer.clear();
+    }
+#endif
+    observeRemoved(0, last);
     endRemoveRows();
 }
 
 template<typename T>
 QVariant QmlListModel<T>::data(const QModelIndex &index, int role) const
 {
+    QML_LIST_STATS(stats()->dataCalled(role));
     if (index.row() < 0 || index.row() >= mData.count())
         return QVariant();
+    /**
+      * The hot cache is filled and read on the model thread only, parallel readers bypass it
+      */
+    if (mViewport != Q_NULLPTR && QThread::currentThread() == thread()) {
+        const QVariant* v = mViewport->find(index.row(), role);
+        if (v != Q_NULLPTR)
+            return *v;
+    }
     const T* data = mData[index.row()];
     return data->metaObject()->property(role).read(data);
 }
@@ -549,9 +4316,16 @@ void QmlListModel<T>::appendData(T *data)
     beginInsertRows(QModelIndex(), mData.count(), mData.count());
     QQmlEngine::setObjectOwnership(data, QQmlEngine::CppOwnership);
     mData.push_back(data);
+    observeInserted(mData.count() - 1, mData.count() - 1);
     endInsertRows();
 }
 
+template<typename T>
+void QmlListModel<T>::appendData(const QList<T*>& data)
+{
+    insertData(mData.count(), data);
+}
+
 template<typename T>
 T *QmlListModel<T>::getData(int i)
 {
@@ -565,9 +4339,37 @@ bool QmlListModel<T>::insertData(int i, T *data)
 {
     if (i < 0 || i > mData.count())
         return false;
+    flushUpdates();
     beginInsertRows(QModelIndex(), i, i);
     QQmlEngine::setObjectOwnership(data, QQmlEngine::CppOwnership);
     mData.insert(mData.begin() + i, data);
+    observeInserted(i, i);
+    endInsertRows();
+    return true;
+}
+
+template<typename T>
+bool QmlListModel<T>::insertData(int i, const QList<T*>& data)
+{
+    if (i < 0 || i > mData.count())
+        return false;
+    if (data.isEmpty())
+        return true;
+    flushUpdates();
+    beginInsertRows(QModelIndex(), i, i + data.count() - 1);
+    for(T* d : data)
+        QQmlEngine::setObjectOwnership(d, QQmlEngine::CppOwnership);
+    if(i == mData.count()){
+        mData.reserve(mData.count() + data.count());
+        mData.append(data);
+    } else {
+        QList<T*> tail = mData.mid(i);
+        mData.erase(mData.begin() + i, mData.end());
+        mData.reserve(mData.count() + data.count() + tail.count());
+        mData.append(data);
+        mData.append(tail);
+    }
+    observeInserted(i, i + data.count() - 1);
     endInsertRows();
     return true;
 }
@@ -587,10 +4389,240 @@ bool QmlListModel<T>::setData(int i, T* data)
         return false;
     if (mData[i] == Q_NULLPTR)
         return false;
-    mData[i]->deleteLater();
+    /**
+      * The row is replaced in this model only, its other models are not notified
+      */
+    QmlListRowRegistry::FanOut replaced;
+    observeAboutToChange(i, i, QVector<int>());
+    releaseLater(mData[i]);
     QQmlEngine::setObjectOwnership(data, QQmlEngine::CppOwnership);
     mData[i] = data;
-    dataChanged(index(i), index(i));
+    if(QmlListRowRegistry::contains(data))
+        QmlListRowRegistry::share(data, this);
+    notifyDataChanged(i, i);
+    return true;
+}
+
+template<typename T>
+template<typename Role>
+bool QmlListModel<T>::setValue(int i, const typename Role::Type& v)
+{
+    if (i < 0 || i >= mData.count())
+        return false;
+    if (mData[i] == Q_NULLPTR)
+        return false;
+    if (Role::get(mData[i]) == v)
+        return true;
+    const QVector<int> roles(1, Role::role());
+    observeAboutToChange(i, i, roles);
+    writeRole<Role>(mData[i], v);
+    notifyDataChanged(i, i, roles);
+    return true;
+}
+
+template<typename T>
+template<typename Role>
+bool QmlListModel<T>::setValues(int first, const QVector<typename Role::Type>& values)
+{
+    if (first < 0 || values.count() > mData.count() - first)
+        return false;
+    if (values.isEmpty())
+        return true;
+    const int last = first + values.count() - 1;
+    const QVector<int> roles(1, Role::role());
+    observeAboutToChange(first, last, roles);
+    for(int i = 0; i < values.count(); ++i)
+        writeRole<Role>(mData[first + i], values.at(i));
+    notifyDataChanged(first, last, roles);
+    return true;
+}
+
+template<typename T>
+QVariantList QmlListModel<T>::getRange_(int from, int count, const QStringList &roles) const
+{
+    QVariantList rows;
+    const QMetaObject& metaData = T::staticMetaObject;
+    QVector<int> properties;
+    if(roles.isEmpty()){
+        for(int j = metaData.propertyOffset(); j < metaData.propertyCount(); ++j)
+            properties.append(j);
+    } else {
+        for(const QString& role : roles){
+            const int j = metaData.indexOfProperty(role.toLatin1().constData());
+            if(j >= 0)
+                properties.append(j);
+        }
+    }
+    const int last = int(qMin<qint64>(mData.count(), qint64(from) + count));
+    if(from < 0 || from >= last)
+        return rows;
+    QVector<QMetaProperty> metaProperties;
+    QVector<QString> names;
+    for(int j : properties){
+        metaProperties.append(metaData.property(j));
+        names.append(QString::fromLatin1(metaData.property(j).name()));
+    }
+    rows.reserve(last - from);
+    for(int i = from; i < last; ++i){
+        QVariantMap row;
+        for(int j = 0; j < metaProperties.size(); ++j)
+            row.insert(names.at(j), metaProperties.at(j).read(mData.at(i)));
+        rows.append(row);
+    }
+    return rows;
+}
+
+template<typename T>
+QVariantList QmlListModel<T>::column_(const QString &role) const
+{
+    QVariantList values;
+    const int j = T::staticMetaObject.indexOfProperty(role.toLatin1().constData());
+    if(j < 0)
+        return values;
+    const QMetaProperty& p = T::staticMetaObject.property(j);
+    values.reserve(mData.count());
+    for(const T* t : mData)
+        values.append(p.read(t));
+    return values;
+}
+
+template<typename T>
+void QmlListModel<T>::forEach_(QJSValue callback)
+{
+    QJSEngine* engine = qjsEngine(this);
+    if(engine == Q_NULLPTR || !callback.isCallable())
+        return;
+    const QMetaObject& metaData = T::staticMetaObject;
+    QVector<QMetaProperty> metaProperties;
+    QVector<QString> names;
+    for(int j = metaData.propertyOffset(); j < metaData.propertyCount(); ++j){
+        metaProperties.append(metaData.property(j));
+        names.append(QString::fromLatin1(metaData.property(j).name()));
+    }
+    for(int i = 0; i < mData.count(); ++i){
+        QJSValue row = engine->newObject();
+        for(int j = 0; j < metaProperties.size(); ++j)
+            row.setProperty(names.at(j), engine->toScriptValue(metaProperties.at(j).read(mData.at(i))));
+        const QJSValue& r = callback.call(QJSValueList() << row << i);
+        if(r.isError()){
+            qDebug()<<"QmlListModel"<<__FUNCTION__<<"Error:"<<r.toString();
+            return;
+        }
+        if(r.isBool() && !r.toBool())
+            return;
+    }
+}
+
+template<typename T>
+bool QmlListModel<T>::shareData(int i, QmlListModel<T>* other, int j)
+{
+    if (i < 0 || i >= mData.count() || other == Q_NULLPTR)
+        return false;
+    if (j < 0)
+        j = other->mData.count();
+    if (j > other->mData.count())
+        return false;
+    T* t = mData.at(i);
+    if (!QmlListRowRegistry::contains(t))
+        QmlListRowRegistry::share(t, this);
+    return other->insertData(j, t);
+}
+
+template<typename T>
+bool QmlListModel<T>::moveData(int from, int to, int count)
+{
+    if (count <= 0 || from < 0 || to < 0 || from + count > mData.count() || to + count > mData.count())
+        return false;
+    if (from == to)
+        return true;
+    flushUpdates();
+    /**
+      * The destination of beginMoveRows is counted before the move
+      */
+    if (!beginMoveRows(QModelIndex(), from, from + count - 1, QModelIndex(), to > from ? to + count : to))
+        return false;
+    if (to > from)
+        std::rotate(mData.begin() + from, mData.begin() + from + count, mData.begin() + to + count);
+    else
+        std::rotate(mData.begin() + to, mData.begin() + from, mData.begin() + from + count);
+    observeMoved(from, from + count - 1, to);
+    endMoveRows();
+    return true;
+}
+
+template<typename T>
+void QmlListModel<T>::setWindow(int capacity)
+{
+    mWindow = qMax(0, capacity);
+    if(mWindow > 0 && mData.count() > mWindow)
+        removeData(0, mData.count() - mWindow);
+    while(mRecycled.size() > mWindow)
+        delete mRecycled.takeLast();
+}
+
+template<typename T>
+void QmlListModel<T>::appendWindowed(T *data)
+{
+    if(data == Q_NULLPTR)
+        return;
+    mWindowQueue.append(data);
+    if(mWindowFlushQueued)
+        return;
+    mWindowFlushQueued = true;
+    QMetaObject::invokeMethod(this, [this](){
+        flushWindow();
+    }, Qt::QueuedConnection);
+}
+
+template<typename T>
+void QmlListModel<T>::flushWindow()
+{
+    mWindowFlushQueued = false;
+    if(mWindowQueue.isEmpty())
+        return;
+    QList<T*> rows;
+    rows.swap(mWindowQueue);
+    if(mWindow > 0 && rows.count() > mWindow){
+        /**
+          * Rows queued and already out of the window are never shown
+          */
+        for(int i = 0; i < rows.count() - mWindow; ++i)
+            recycle(rows.at(i));
+        rows.erase(rows.begin(), rows.end() - mWindow);
+    }
+    const int evicted = mWindow > 0 ? qMin(mData.count(), mData.count() + rows.count() - mWindow) : 0;
+    if(evicted > 0){
+        flushUpdates();
+        beginRemoveRows(QModelIndex(), 0, evicted - 1);
+        observeAboutToBeRemoved(0, evicted - 1);
+        for(int i = 0; i < evicted; ++i)
+            recycle(mData.at(i));
+        /**
+          * QList drops its head in O(1)
+          */
+        mData.erase(mData.begin(), mData.begin() + evicted);
+        observeRemoved(0, evicted - 1);
+        endRemoveRows();
+    }
+    insertData(mData.count(), rows);
+}
+
+template<typename T>
+bool QmlListModel<T>::removeData(int first, int count)
+{
+    if (first < 0 || count < 0 || first + count > mData.count())
+        return false;
+    if (count == 0)
+        return true;
+    flushUpdates();
+    const int last = first + count - 1;
+    for(int i = first; i <= last; ++i)
+        releaseLater(mData.at(i));
+    beginRemoveRows(QModelIndex(), first, last);
+    observeAboutToBeRemoved(first, last);
+    mData.erase(mData.begin() + first, mData.begin() + last + 1);
+    observeRemoved(first, last);
+    endRemoveRows();
     return true;
 }
 
@@ -601,13 +4633,99 @@ bool QmlListModel<T>::removeData(int i)
         return false;
     if (mData[i] == Q_NULLPTR)
         return false;
-    mData[i]->deleteLater();
+    flushUpdates();
+    releaseLater(mData[i]);
     beginRemoveRows(QModelIndex(), i, i);
+    observeAboutToBeRemoved(i, i);
     mData.erase(mData.begin() + i);
+    observeRemoved(i, i);
     endRemoveRows();
     return true;
 }
 
+template<typename T>
+void QmlListModel<T>::setUpdateThrottle(int maxRate)
+{
+    flushUpdates();
+    mThrottleRate = maxRate;
+    if(mThrottleRate > 0){
+        if(mThrottleTimer == Q_NULLPTR){
+            mThrottleTimer = new QTimer(this);
+            mThrottleTimer->setSingleShot(true);
+            QObject::connect(mThrottleTimer, &QTimer::timeout, this, [this](){ flushUpdates(); });
+        }
+        mThrottleTimer->setInterval(qMax(1, 1000 / mThrottleRate));
+    } else if(mThrottleTimer != Q_NULLPTR){
+        mThrottleTimer->stop();
+    }
+}
+
+template<typename T>
+void QmlListModel<T>::flushUpdates()
+{
+    if(mDirtyFirst < 0)
+        return;
+    QVector<int> roles;
+    if(!mDirtyAllRoles){
+        for(int r = 0; r < mDirtyRoles.size(); ++r){
+            if(mDirtyRoles.testBit(r))
+                roles.append(r);
+        }
+    }
+    const int first = mDirtyFirst,
+              last = qMin(mDirtyLast, mData.count() - 1);
+    mDirtyFirst = mDirtyLast = -1;
+    mDirtyAllRoles = false;
+    mDirtyRoles.fill(false);
+    /**
+      * Merge the dirty bits into contiguous ranges
+      */
+    for(int i = first; i <= last; ++i){
+        if(!mDirtyRows.testBit(i))
+            continue;
+        int j = i;
+        while(j < last && mDirtyRows.testBit(j + 1))
+            ++j;
+        emit dataChanged(index(i), index(j), roles);
+        ++mUpdatesEmitted;
+        QML_LIST_STATS(stats()->dataChangedSent(1));
+        i = j;
+    }
+    mDirtyRows.fill(false, first, qMax(first, last + 1));
+    if(mThrottleTimer != Q_NULLPTR)
+        mThrottleTimer->stop();
+}
+
+template<typename T>
+void QmlListModel<T>::notifyDataChanged(int first, int last, const QVector<int> &roles)
+{
+    observeChanged(first, last, roles);
+    mUpdatesReceived += last - first + 1;
+    if(mThrottleRate == 0){
+        emit dataChanged(index(first), index(last), roles);
+        ++mUpdatesEmitted;
+        QML_LIST_STATS(stats()->dataChangedSent(1));
+        return;
+    }
+    if(mDirtyRows.size() < mData.count())
+        mDirtyRows.resize(mData.count());
+    if(mDirtyRoles.isEmpty())
+        mDirtyRoles.resize(T::staticMetaObject.propertyCount());
+    mDirtyRows.fill(true, first, last + 1);
+    if(roles.isEmpty()){
+        mDirtyAllRoles = true;
+    } else {
+        for(int r : roles){
+            if(r >= 0 && r < mDirtyRoles.size())
+                mDirtyRoles.setBit(r);
+        }
+    }
+    mDirtyFirst = mDirtyFirst < 0 ? first : qMin(mDirtyFirst, first);
+    mDirtyLast = qMax(mDirtyLast, last);
+    if(mThrottleTimer != Q_NULLPTR && mThrottleRate > 0 && !mThrottleTimer->isActive())
+        mThrottleTimer->start();
+}
+
 template<typename T>
 QHash<int, QByteArray> QmlListModel<T>::roleNames() const
 {
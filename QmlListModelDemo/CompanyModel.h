@@ -18,6 +18,8 @@ public:
     MemberModel*    mMembers;
 };
 
+QML_LIST_ROLE(ApartmentNameRole, Apartment, mName, apartmentName);
+
 class CompanyModel : public QmlListModel<Apartment>
 {
     Q_OBJECT
@@ -14,6 +14,8 @@ public:
     QString mName;
 };
 
+QML_LIST_ROLE(MemberNameRole, Member, mName, memberName);
+
 class MemberModel : public QmlListModel<Member>
 {
     Q_OBJECT
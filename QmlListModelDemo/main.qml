@@ -33,15 +33,9 @@ Window {
                         text: "Add Member"
                         onClicked: {
                             if(inputName.text != ""){
-                                var newName = inputName.text,
-                                    existed = false
-                                // Iteration
-                                for(var i = 0; i < members.size(); i++){
-                                    // Access data
-                                    if(members.get(i).memberName == newName)
-                                        existed = true
-                                }
-                                if(!existed)
+                                var newName = inputName.text
+                                // Access the whole role in one call
+                                if(members.column("memberName").indexOf(newName) < 0)
                                     members.addMember(newName)
                             }
                         }
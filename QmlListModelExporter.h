@@ -0,0 +1,302 @@
+#ifndef QMLLISTMODELEXPORTER_H
+#define QMLLISTMODELEXPORTER_H
+
+#include "QmlListModel.h"
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QSemaphore>
+
+/**
+ * @brief The QmlListModelExporter class streams a snapshot of a model into a file or device
+ * on a worker thread, one chunk of rows at a time. The snapshot holds the values of every row:
+ * a one-off copy read on the model thread, O(n), and released with the export, or with
+ * QAbstractBase::setSnapshotTracking(true) the chunks shared with the tracker.
+ * The export adds one encoded chunk to that whatever the row count.
+ * The output is the same as serialize() or the compact toJsonDoc(), and can be cancelled at any chunk.
+ */
+class QmlListModelExporter : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(int rowsWritten READ rowsWritten NOTIFY progress)
+    Q_PROPERTY(int rowsTotal READ rowsTotal NOTIFY progress)
+    Q_PROPERTY(QString errorString READ errorString NOTIFY finished)
+public:
+    enum Format {
+        Bytes,
+        Json
+    };
+    Q_ENUM(Format)
+
+    explicit QmlListModelExporter(QObject *parent = 0):
+        QObject(parent), mWritten(0), mTotal(0){}
+
+    /**
+     * @brief ~QmlListModelExporter cancels the export and waits for the worker to stop,
+     * so the device is no longer written when the exporter is gone
+     */
+    ~QmlListModelExporter(){
+        if(mJob.isNull())
+            return;
+        QSharedPointer<Job> job = mJob;
+        cancel();
+        job->stopped.acquire();
+    }
+
+    inline bool isRunning() const {
+        return !mJob.isNull();
+    }
+
+    inline int rowsWritten() const {
+        return mWritten;
+    }
+
+    inline int rowsTotal() const {
+        return mTotal;
+    }
+
+    inline QString errorString() const {
+        return mError;
+    }
+
+    /**
+     * @brief start exports the rows of model as they are now. The rows are copied once on the
+     * calling thread, no tracker is installed on model and the copy is released when the export ends.
+     * @param model
+     * @param fileName
+     * @param format
+     * @return Whether the export started
+     */
+    Q_INVOKABLE inline bool start(QObject* model, const QString& fileName, Format format = Json){
+        QAbstractBase* base = dynamic_cast<QAbstractBase*>(model);
+        if(base == Q_NULLPTR){
+            qDebug()<<"QmlListModelExporter"<<__FUNCTION__<<"Error: Not a QmlListModel.";
+            return false;
+        }
+        return start(base->snapshot(), fileName, format);
+    }
+
+    /**
+     * @brief start writes the snapshot to a QSaveFile, which replaces fileName only when
+     * the export succeeds
+     * @param snapshot
+     * @param fileName
+     * @param format
+     * @return Whether the export started
+     */
+    bool start(const QmlListModelSnapshot& snapshot, const QString& fileName, Format format = Json){
+        return run(snapshot, format, [fileName](const Writer& write, QString* error){
+            QSaveFile file(fileName);
+            if(!file.open(QIODevice::WriteOnly)){
+                *error = file.errorString();
+                return false;
+            }
+            if(!write(&file, error)){
+                file.cancelWriting();
+                return false;
+            }
+            if(!file.commit()){
+                *error = file.errorString();
+                return false;
+            }
+            return true;
+        });
+    }
+
+    /**
+     * @brief start writes the snapshot to an open device from the worker thread.
+     * The device must not be used meanwhile and must not need an event loop, e.g. a QFile or a QBuffer.
+     * @param snapshot
+     * @param device
+     * @param format
+     * @return Whether the export started
+     */
+    bool start(const QmlListModelSnapshot& snapshot, QIODevice* device, Format format = Json){
+        if(device == Q_NULLPTR || !device->isWritable()){
+            qDebug()<<"QmlListModelExporter"<<__FUNCTION__<<"Error: Device not writable.";
+            return false;
+        }
+        return run(snapshot, format, [device](const Writer& write, QString* error){
+            return write(device, error);
+        });
+    }
+
+    /**
+     * @brief cancel stops the running export after its current chunk,
+     * finished(false) is emitted once the worker has stopped
+     */
+    Q_INVOKABLE void cancel(){
+        if(mJob.isNull())
+            return;
+        mJob->cancelled.storeRelease(1);
+    }
+
+signals:
+    void runningChanged();
+
+    /**
+     * @brief progress is emitted after the chunks written, at most one pending at a time
+     * @param rows
+     * @param total
+     */
+    void progress(int rows, int total);
+
+    void finished(bool ok);
+
+private:
+    typedef std::function<bool(QIODevice*, QString*)> Writer;
+    typedef std::function<bool(const Writer&, QString*)> Target;
+
+    struct Job {
+        QAtomicInt  cancelled;
+        QAtomicInt  written;
+        QAtomicInt  progressPending;
+        QSemaphore  stopped;
+    };
+
+    class Task : public QRunnable
+    {
+    public:
+        explicit Task(const std::function<void()>& f):
+            mF(f){}
+        void run() override {
+            mF();
+        }
+    private:
+        std::function<void()> mF;
+    };
+
+    bool run(const QmlListModelSnapshot& snapshot, Format format, const Target& target){
+        if(!mJob.isNull()){
+            qDebug()<<"QmlListModelExporter"<<__FUNCTION__<<"Error: Already running.";
+            return false;
+        }
+#if !UsingSerialize
+        if(format == Bytes){
+            qDebug()<<"QmlListModelExporter"<<__FUNCTION__<<"Error: Bytes need UsingSerialize.";
+            return false;
+        }
+#endif
+#if !UsingJson
+        if(format == Json){
+            qDebug()<<"QmlListModelExporter"<<__FUNCTION__<<"Error: Json needs UsingJson.";
+            return false;
+        }
+#endif
+        QSharedPointer<Job> job(new Job);
+        job->cancelled.storeRelease(0);
+        job->written.storeRelease(0);
+        job->progressPending.storeRelease(0);
+        mJob = job;
+        mWritten = 0;
+        mTotal = snapshot.size();
+        mError.clear();
+        emit runningChanged();
+        QPointer<QmlListModelExporter> self(this);
+        QThreadPool::globalInstance()->start(new Task([job, snapshot, format, target, self](){
+            const Writer write = [&](QIODevice* device, QString* error){
+                return writeSnapshot(snapshot, format, device, job, self, error);
+            };
+            QString error;
+            const bool ok = target(write, &error);
+            if(!ok && job->cancelled.loadAcquire())
+                error = QStringLiteral("Cancelled");
+            QMetaObject::invokeMethod(qApp, [job, self, ok, error](){
+                if(!self.isNull() && self->mJob == job)
+                    self->finish(ok, error);
+            }, Qt::QueuedConnection);
+            job->stopped.release();
+        }));
+        return true;
+    }
+
+    /**
+     * @brief writeSnapshot writes the chunks of the snapshot in order, on the worker thread
+     */
+    static bool writeSnapshot(const QmlListModelSnapshot& snapshot, Format format, QIODevice* device,
+                              const QSharedPointer<Job>& job, const QPointer<QmlListModelExporter>& self, QString* error){
+        const QVector<QVector<QmlListModelSnapshot::Row> >& chunks = snapshot.rope().chunks;
+#if UsingSerialize
+        if(format == Bytes){
+            QDataStream s(device);
+            s << quint32(snapshot.size());
+            for(const QVector<QmlListModelSnapshot::Row>& chunk : chunks){
+                if(job->cancelled.loadAcquire())
+                    return false;
+                snapshot.writeRows(s, chunk);
+                if(s.status() != QDataStream::Ok){
+                    *error = device->errorString();
+                    return false;
+                }
+                report(job, chunk.size(), snapshot.size(), self);
+            }
+            return true;
+        }
+#endif
+#if UsingJson
+        if(format == Json){
+            QByteArray part("[");
+            bool first = true;
+            for(const QVector<QmlListModelSnapshot::Row>& chunk : chunks){
+                if(job->cancelled.loadAcquire())
+                    return false;
+                for(const QmlListModelSnapshot::Row& r : chunk){
+                    if(!first)
+                        part.append(',');
+                    first = false;
+                    part.append(QJsonDocument(snapshot.rowToJson(r)).toJson(QJsonDocument::Compact));
+                }
+                if(device->write(part) != part.size()){
+                    *error = device->errorString();
+                    return false;
+                }
+                part.clear();
+                report(job, chunk.size(), snapshot.size(), self);
+            }
+            if(device->write("]", 1) != 1){
+                *error = device->errorString();
+                return false;
+            }
+            return true;
+        }
+#endif
+        Q_UNUSED(chunks)
+        Q_UNUSED(self)
+        *error = QStringLiteral("Unsupported format");
+        return false;
+    }
+
+    /**
+     * @brief report posts the progress unless the previous one is still pending
+     */
+    static void report(const QSharedPointer<Job>& job, int rows, int total, const QPointer<QmlListModelExporter>& self){
+        job->written.fetchAndAddOrdered(rows);
+        if(!job->progressPending.testAndSetOrdered(0, 1))
+            return;
+        QMetaObject::invokeMethod(qApp, [job, total, self](){
+            job->progressPending.storeRelease(0);
+            if(self.isNull() || self->mJob != job)
+                return;
+            self->mWritten = job->written.loadAcquire();
+            emit self->progress(self->mWritten, total);
+        }, Qt::QueuedConnection);
+    }
+
+    void finish(bool ok, const QString& error){
+        mJob.reset();
+        if(ok)
+            mWritten = mTotal;
+        else
+            mError = error;
+        emit finished(ok);
+        emit runningChanged();
+    }
+
+    QSharedPointer<Job> mJob;
+    int                 mWritten;
+    int                 mTotal;
+    QString             mError;
+};
+
+#endif // QMLLISTMODELEXPORTER_H
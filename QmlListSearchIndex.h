@@ -0,0 +1,384 @@
+#ifndef QMLLISTSEARCHINDEX_H
+#define QMLLISTSEARCHINDEX_H
+
+#include "QmlListModel.h"
+#include <QCoreApplication>
+
+/**
+ * @brief The QmlListSearchIndex class indexes string roles of a QmlListModel for type-to-filter.
+ * Substring queries go through a trigram inverted index, prefix queries through an ordered
+ * word map, so a query costs the size of its result rather than the size of the model.
+ * The index observes the model and stays current through its insertions, removals and changes.
+ * Its map of row objects to rows is dropped by an insertion, removal or move and rebuilt
+ * by the next query, so a burst of mutations costs one renumbering.
+ * build() indexes on the calling thread, buildAsync() copies the indexed strings
+ * and indexes them on a worker thread.
+ */
+class QmlListSearchIndex : public QObject, public QmlListModelObserver
+{
+    Q_OBJECT
+    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
+public:
+    enum Mode {
+        Contains,
+        Prefix
+    };
+    Q_ENUM(Mode)
+
+    /**
+     * @brief QmlListSearchIndex
+     * @param model The indexed model, it must outlive the index
+     * @param roles The names of the QString roles to index
+     * @param parent
+     */
+    QmlListSearchIndex(QAbstractBase* model, const QStringList& roles, QObject* parent = 0):
+        QObject(parent), mModel(model), mReady(false), mBuilding(false), mRowsValid(false)
+    {
+        for(const QString& role : roles){
+            const int p = model->rowMetaObject()->indexOfProperty(role.toLatin1().constData());
+            if(p >= 0)
+                mProperties.append(p);
+            else
+                qDebug()<<"QmlListSearchIndex"<<__FUNCTION__<<"Error: Wrong role."<<role;
+        }
+        mModel->addObserver(this);
+    }
+
+    ~QmlListSearchIndex(){
+        mModel->removeObserver(this);
+        if(mBuilding)
+            mBuild->cancelled.storeRelease(1);
+    }
+
+    inline bool isReady() const {
+        return mReady;
+    }
+
+    /**
+     * @brief build indexes all rows on the calling thread
+     */
+    void build(){
+        cancelBuild();
+        mIndex = Index();
+        for(int i = 0; i < mModel->rowCount(QModelIndex()); ++i)
+            indexObject(mIndex, mModel->rowObject(i), readValues(mModel->rowObject(i)));
+        setReady(true);
+    }
+
+    /**
+     * @brief buildAsync copies the indexed strings of the rows on the calling thread
+     * and indexes them on a worker thread, the changes made meanwhile are applied when it finishes.
+     */
+    void buildAsync(){
+        cancelBuild();
+        mBuilding = true;
+        mPending.clear();
+        QSharedPointer<Build> build(new Build);
+        build->cancelled.storeRelease(0);
+        mBuild = build;
+        /**
+          * Only the indexed properties are read here, the lowering and indexing run on the worker
+          */
+        const int count = mModel->rowCount(QModelIndex()), width = mProperties.size();
+        QVector<const QObject*> objects(count);
+        QVector<QString> strings(count * width);
+        for(int i = 0; i < count; ++i){
+            const QObject* obj = mModel->rowObject(i);
+            objects[i] = obj;
+            if(obj == Q_NULLPTR)
+                continue;
+            for(int c = 0; c < width; ++c)
+                strings[i * width + c] = mModel->rowMetaObject()->property(mProperties.at(c)).read(obj).toString();
+        }
+        QPointer<QmlListSearchIndex> self(this);
+        QThreadPool::globalInstance()->start(new BuildTask([build, objects, strings, width, self](){
+            for(int i = 0; i < objects.size() && !build->cancelled.loadAcquire(); ++i){
+                QStringList values;
+                for(int c = 0; c < width; ++c)
+                    values.append(strings.at(i * width + c).toLower());
+                indexObject(build->index, objects.at(i), values);
+            }
+            QMetaObject::invokeMethod(qApp, [build, self](){
+                if(!self.isNull() && !build->cancelled.loadAcquire())
+                    self->finishBuild(build);
+            }, Qt::QueuedConnection);
+        }));
+    }
+
+    /**
+     * @brief rows
+     * @param text
+     * @param mode
+     * @return The matching rows in ascending order, all rows for an empty text
+     */
+    QVector<int> rows(const QString& text, Mode mode = Contains){
+        QVector<int> result;
+        if(!mReady)
+            return result;
+        updateRows();
+        const QString& q = text.toLower();
+        if(q.isEmpty()){
+            for(int i = 0; i < mModel->rowCount(QModelIndex()); ++i)
+                result.append(i);
+            return result;
+        }
+        QSet<const QObject*> matches;
+        if(mode == Prefix){
+            for(auto it = mIndex.words.lowerBound(q); it != mIndex.words.end() && it.key().startsWith(q); ++it)
+                matches.unite(it.value());
+        } else if(q.size() >= 3){
+            /**
+              * Intersect the trigram posting lists from the smallest, then verify
+              */
+            QVector<const QSet<const QObject*>*> lists;
+            for(int i = 0; i + 3 <= q.size(); ++i){
+                auto it = mIndex.grams.constFind(gram(q, i));
+                if(it == mIndex.grams.constEnd())
+                    return result;
+                lists.append(&it.value());
+            }
+            std::sort(lists.begin(), lists.end(), [](const QSet<const QObject*>* a, const QSet<const QObject*>* b){
+                return a->size() < b->size();
+            });
+            for(const QObject* obj : *lists.first()){
+                bool all = true;
+                for(int l = 1; l < lists.size() && all; ++l)
+                    all = lists.at(l)->contains(obj);
+                if(all && containsText(mIndex.values.value(obj), q))
+                    matches.insert(obj);
+            }
+        } else {
+            for(auto it = mIndex.values.constBegin(); it != mIndex.values.constEnd(); ++it){
+                if(containsText(it.value(), q))
+                    matches.insert(it.key());
+            }
+        }
+        result.reserve(matches.size());
+        for(const QObject* obj : matches){
+            const int row = mRows.value(obj, -1);
+            if(row >= 0)
+                result.append(row);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    /**
+     * @brief search
+     * @param text
+     * @param mode
+     * @return The matching rows in ascending order
+     */
+    Q_INVOKABLE inline QVariantList search(const QString& text, int mode = Contains){
+        QVariantList list;
+        for(int row : rows(text, Mode(mode)))
+            list.append(row);
+        return list;
+    }
+
+    void rowsInserted(int first, int last) override {
+        mRowsValid = false;
+        for(int i = first; i <= last; ++i)
+            reindex(mModel->rowObject(i));
+    }
+
+    void rowsAboutToBeRemoved(int first, int last) override {
+        mRowsValid = false;
+        for(int i = first; i <= last; ++i)
+            unindex(mModel->rowObject(i));
+    }
+
+    void rowsMoved(int first, int last, int to) override {
+        Q_UNUSED(first);
+        Q_UNUSED(last);
+        Q_UNUSED(to);
+        mRowsValid = false;
+    }
+
+    void rowsAboutToChange(int first, int last, const QVector<int>& roles) override {
+        /**
+          * A change of all roles may replace the row objects
+          */
+        if(roles.isEmpty())
+            mRowsValid = false;
+        if(!relevant(roles))
+            return;
+        for(int i = first; i <= last; ++i)
+            unindex(mModel->rowObject(i));
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        if(!relevant(roles))
+            return;
+        for(int i = first; i <= last; ++i)
+            reindex(mModel->rowObject(i));
+    }
+
+signals:
+    void readyChanged();
+
+private:
+    struct Index {
+        QHash<const QObject*, QStringList>              values;
+        QHash<quint64, QSet<const QObject*> >           grams;
+        QMap<QString, QSet<const QObject*> >            words;
+    };
+
+    struct Build {
+        Index       index;
+        QAtomicInt  cancelled;
+    };
+
+    class BuildTask : public QRunnable
+    {
+    public:
+        explicit BuildTask(const std::function<void()>& f):
+            mF(f){}
+        void run() override {
+            mF();
+        }
+    private:
+        std::function<void()> mF;
+    };
+
+    static inline quint64 gram(const QString& s, int i){
+        return (quint64(s.at(i).unicode()) << 32) | (quint64(s.at(i + 1).unicode()) << 16) | quint64(s.at(i + 2).unicode());
+    }
+
+    static inline bool containsText(const QStringList& values, const QString& q){
+        for(const QString& v : values){
+            if(v.contains(q))
+                return true;
+        }
+        return false;
+    }
+
+    static void indexObject(Index& index, const QObject* obj, const QStringList& values){
+        if(obj == Q_NULLPTR)
+            return;
+        index.values.insert(obj, values);
+        for(const QString& v : values){
+            for(int i = 0; i + 3 <= v.size(); ++i)
+                index.grams[gram(v, i)].insert(obj);
+            for(const QString& w : v.split(QLatin1Char(' '), QString::SkipEmptyParts))
+                index.words[w].insert(obj);
+            index.words[v].insert(obj);
+        }
+    }
+
+    static void unindexObject(Index& index, const QObject* obj){
+        auto it = index.values.find(obj);
+        if(it == index.values.end())
+            return;
+        for(const QString& v : it.value()){
+            for(int i = 0; i + 3 <= v.size(); ++i){
+                auto g = index.grams.find(gram(v, i));
+                if(g != index.grams.end()){
+                    g->remove(obj);
+                    if(g->isEmpty())
+                        index.grams.erase(g);
+                }
+            }
+            QStringList words = v.split(QLatin1Char(' '), QString::SkipEmptyParts);
+            words.append(v);
+            for(const QString& w : words){
+                auto word = index.words.find(w);
+                if(word != index.words.end()){
+                    word->remove(obj);
+                    if(word->isEmpty())
+                        index.words.erase(word);
+                }
+            }
+        }
+        index.values.erase(it);
+    }
+
+    inline QStringList readValues(const QObject* obj) const {
+        QStringList values;
+        if(obj == Q_NULLPTR)
+            return values;
+        for(int p : mProperties)
+            values.append(mModel->rowMetaObject()->property(p).read(obj).toString().toLower());
+        return values;
+    }
+
+    inline bool relevant(const QVector<int>& roles) const {
+        if(roles.isEmpty())
+            return true;
+        for(int p : mProperties){
+            if(roles.contains(p))
+                return true;
+        }
+        return false;
+    }
+
+    inline void reindex(const QObject* obj){
+        if(mBuilding)
+            mPending.insert(obj);
+        unindexObject(mIndex, obj);
+        indexObject(mIndex, obj, readValues(obj));
+    }
+
+    inline void unindex(const QObject* obj){
+        if(mBuilding)
+            mPending.insert(obj);
+        unindexObject(mIndex, obj);
+    }
+
+    inline void updateRows(){
+        if(mRowsValid)
+            return;
+        mRows.clear();
+        const int count = mModel->rowCount(QModelIndex());
+        mRows.reserve(count);
+        for(int i = 0; i < count; ++i)
+            mRows.insert(mModel->rowObject(i), i);
+        mRowsValid = true;
+    }
+
+    inline void cancelBuild(){
+        if(mBuilding){
+            mBuild->cancelled.storeRelease(1);
+            mBuild.clear();
+            mBuilding = false;
+        }
+    }
+
+    void finishBuild(const QSharedPointer<Build>& build){
+        if(build != mBuild)
+            return;
+        mIndex = build->index;
+        mBuild.clear();
+        mBuilding = false;
+        /**
+          * Apply the changes made while building
+          */
+        updateRows();
+        for(const QObject* obj : mPending){
+            unindexObject(mIndex, obj);
+            if(mRows.contains(obj))
+                indexObject(mIndex, obj, readValues(obj));
+        }
+        mPending.clear();
+        setReady(true);
+    }
+
+    inline void setReady(bool ready){
+        if(mReady != ready){
+            mReady = ready;
+            emit readyChanged();
+        }
+    }
+
+    QAbstractBase*                  mModel;
+    QVector<int>                    mProperties;
+    Index                           mIndex;
+    bool                            mReady;
+    bool                            mBuilding;
+    QSharedPointer<Build>           mBuild;
+    QSet<const QObject*>            mPending;
+    QHash<const QObject*, int>      mRows;
+    bool                            mRowsValid;
+};
+
+#endif // QMLLISTSEARCHINDEX_H
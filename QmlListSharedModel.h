@@ -0,0 +1,699 @@
+#ifndef QMLLISTSHAREDMODEL_H
+#define QMLLISTSHAREDMODEL_H
+
+#include "QmlListModel.h"
+#include <QSharedMemory>
+#include <atomic>
+#include <cstring>
+
+/**
+ * @brief The QmlListSharedLayout class describes a shared memory segment holding the rows of a model.
+ * Segment: header, field table, change ring, then fixed size row records.
+ * A record stores bool, integer and floating point roles inline and QString roles
+ * as a length followed by at most stringLength UTF-16 code units.
+ * The writer holds an odd sequence while it changes the segment, the readers
+ * retry whatever they read under an odd or moved sequence.
+ */
+class QmlListSharedLayout
+{
+public:
+    struct Header {
+        quint32                         magic;
+        quint32                         version;
+        quint32                         fieldCount;
+        quint32                         rowSize;
+        quint32                         capacity;
+        quint32                         ringCapacity;
+        quint32                         stringLength;
+        quint32                         rowCount;
+        QBasicAtomicInteger<quint32>    sequence;
+        quint32                         reserved;
+        quint64                         operations;
+    };
+
+    struct Field {
+        char        name[56];
+        qint32      type;
+        quint32     offset;
+    };
+
+    struct Operation {
+        quint32     operation;
+        quint32     first;
+        quint32     count;
+        quint32     to;
+    };
+
+    enum OperationType {
+        Insert,
+        Remove,
+        Change,
+        Reset,
+        Move
+    };
+
+    /**
+     * @brief Magic number of the segment, "QLSM"
+     */
+    static const quint32 Magic      = 0x514C534D;
+    static const quint32 Version    = 1;
+
+    /**
+     * @brief fieldSize
+     * @param type
+     * @param stringLength
+     * @return The bytes of a field in a record, 0 for an unsupported type
+     */
+    static inline int fieldSize(int type, int stringLength){
+        switch(type){
+        case QMetaType::Bool:       return 1;
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Float:      return 4;
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Double:     return 8;
+        case QMetaType::QString:    return 4 + 2 * stringLength;
+        default:                    return 0;
+        }
+    }
+
+    static inline int align(int size){
+        return (size + 7) & ~7;
+    }
+
+    static inline Header* header(void* data){
+        return reinterpret_cast<Header*>(data);
+    }
+
+    static inline Field* fields(void* data){
+        return reinterpret_cast<Field*>(static_cast<char*>(data) + align(sizeof(Header)));
+    }
+
+    static inline Operation* ring(void* data){
+        return reinterpret_cast<Operation*>(reinterpret_cast<char*>(fields(data)) + align(header(data)->fieldCount * sizeof(Field)));
+    }
+
+    static inline char* row(void* data, int i){
+        const Header* h = header(data);
+        return reinterpret_cast<char*>(ring(data) + h->ringCapacity) + qint64(i) * h->rowSize;
+    }
+
+    static inline qint64 segmentSize(qint64 fieldCount, qint64 rowSize, qint64 capacity, qint64 ringCapacity){
+        return align(sizeof(Header)) + ((fieldCount * qint64(sizeof(Field)) + 7) & ~qint64(7))
+                + ringCapacity * qint64(sizeof(Operation)) + capacity * rowSize;
+    }
+
+    /**
+     * @brief Fields and UTF-16 code units per string a reader accepts at most
+     */
+    static const quint32 MaxFields          = 1024;
+    static const quint32 MaxStringLength    = 1 << 20;
+
+    /**
+     * @brief isValid checks a copied header against the mapped size, before anything behind it is read
+     * @param h
+     * @param size
+     * @return Whether the field table, the ring and the records lie within size
+     */
+    static inline bool isValid(const Header& h, qint64 size){
+        return h.magic == Magic && h.version == Version && h.fieldCount <= MaxFields
+                && h.stringLength <= MaxStringLength && h.ringCapacity > 0 && h.rowSize > 0
+                && segmentSize(h.fieldCount, h.rowSize, h.capacity, h.ringCapacity) <= size;
+    }
+
+    /**
+     * @brief isValid
+     * @param f a copied field
+     * @param h the validated header
+     * @return Whether the field has a supported type, lies within a record and has a terminated name
+     */
+    static inline bool isValid(const Field& f, const Header& h){
+        const int bytes = fieldSize(f.type, int(h.stringLength));
+        return bytes > 0 && qint64(f.offset) + bytes <= qint64(h.rowSize)
+                && qstrnlen(f.name, sizeof(f.name)) < sizeof(f.name);
+    }
+
+    static inline void writeField(char* record, const Field& f, const QVariant& v, int stringLength){
+        char* p = record + f.offset;
+        switch(f.type){
+        case QMetaType::Bool:       { const quint8 b = v.toBool(); std::memcpy(p, &b, 1); break; }
+        case QMetaType::Int:        { const qint32 i = v.toInt(); std::memcpy(p, &i, 4); break; }
+        case QMetaType::UInt:       { const quint32 i = v.toUInt(); std::memcpy(p, &i, 4); break; }
+        case QMetaType::Float:      { const float d = v.toFloat(); std::memcpy(p, &d, 4); break; }
+        case QMetaType::LongLong:   { const qint64 i = v.toLongLong(); std::memcpy(p, &i, 8); break; }
+        case QMetaType::ULongLong:  { const quint64 i = v.toULongLong(); std::memcpy(p, &i, 8); break; }
+        case QMetaType::Double:     { const double d = v.toDouble(); std::memcpy(p, &d, 8); break; }
+        case QMetaType::QString: {
+            const QString& s = v.toString();
+            const quint32 length = quint32(qMin(s.size(), stringLength));
+            std::memcpy(p, &length, 4);
+            std::memcpy(p + 4, s.utf16(), length * 2);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    static inline QVariant readField(const char* record, const Field& f, int stringLength){
+        const char* p = record + f.offset;
+        switch(f.type){
+        case QMetaType::Bool:       { quint8 b; std::memcpy(&b, p, 1); return bool(b); }
+        case QMetaType::Int:        { qint32 i; std::memcpy(&i, p, 4); return i; }
+        case QMetaType::UInt:       { quint32 i; std::memcpy(&i, p, 4); return i; }
+        case QMetaType::Float:      { float d; std::memcpy(&d, p, 4); return d; }
+        case QMetaType::LongLong:   { qint64 i; std::memcpy(&i, p, 8); return i; }
+        case QMetaType::ULongLong:  { quint64 i; std::memcpy(&i, p, 8); return i; }
+        case QMetaType::Double:     { double d; std::memcpy(&d, p, 8); return d; }
+        case QMetaType::QString: {
+            quint32 length;
+            std::memcpy(&length, p, 4);
+            return QString(reinterpret_cast<const QChar*>(p + 4), int(qMin(length, quint32(stringLength))));
+        }
+        default:
+            return QVariant();
+        }
+    }
+};
+
+/**
+ * @brief The QmlListSharedPublisher class mirrors a model into a shared memory segment for the
+ * QmlListSharedModel of other processes on the same host. It observes the model, so every change made
+ * through the model API is written to the row records and announced in the change ring.
+ * Nested list models and roles of other types are not shared.
+ */
+class QmlListSharedPublisher : public QmlListModelObserver
+{
+public:
+    /**
+     * @brief QmlListSharedPublisher creates the segment and writes the current rows
+     * @param model The published model, it must outlive the publisher
+     * @param key The QSharedMemory key
+     * @param capacity Rows the segment holds at most
+     * @param stringLength UTF-16 code units of every QString role, longer strings are cut
+     * @param ringCapacity Operations kept for the readers which poll late
+     */
+    QmlListSharedPublisher(QAbstractBase* model, const QString& key, int capacity,
+                           int stringLength = 64, int ringCapacity = 4096):
+        mModel(model), mMemory(key), mStringLength(stringLength)
+    {
+        const QMetaObject* metaData = model->rowMetaObject();
+        QVector<QmlListSharedLayout::Field> fields;
+        int rowSize = 0;
+        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j){
+            const QMetaProperty& p = metaData->property(j);
+            const int size = QmlListSharedLayout::fieldSize(p.userType(), stringLength);
+            if(size == 0 || QAbstractBase::isSubList(p)){
+                qDebug()<<"QmlListSharedPublisher"<<__FUNCTION__<<"Error: Unsupported property."<<p.typeName()<<p.name();
+                continue;
+            }
+            QmlListSharedLayout::Field f;
+            std::memset(&f, 0, sizeof(f));
+            qstrncpy(f.name, p.name(), sizeof(f.name));
+            f.type = p.userType();
+            f.offset = quint32(rowSize);
+            rowSize += QmlListSharedLayout::align(size);
+            fields.append(f);
+            mProperties.append(j);
+        }
+        if(!mMemory.create(int(QmlListSharedLayout::segmentSize(fields.size(), rowSize, capacity, ringCapacity)))){
+            qDebug()<<"QmlListSharedPublisher"<<__FUNCTION__<<"Error:"<<mMemory.errorString();
+            return;
+        }
+        void* data = mMemory.data();
+        std::memset(data, 0, size_t(mMemory.size()));
+        QmlListSharedLayout::Header* h = QmlListSharedLayout::header(data);
+        h->magic = QmlListSharedLayout::Magic;
+        h->version = QmlListSharedLayout::Version;
+        h->fieldCount = quint32(fields.size());
+        h->rowSize = quint32(rowSize);
+        h->capacity = quint32(capacity);
+        h->ringCapacity = quint32(ringCapacity);
+        h->stringLength = quint32(stringLength);
+        std::memcpy(QmlListSharedLayout::fields(data), fields.constData(), fields.size() * sizeof(QmlListSharedLayout::Field));
+        rewrite();
+        mModel->addObserver(this);
+    }
+
+    ~QmlListSharedPublisher(){
+        if(isAttached())
+            mModel->removeObserver(this);
+    }
+
+    inline bool isAttached() const {
+        return mMemory.isAttached();
+    }
+
+    void rowsInserted(int first, int last) override {
+        QmlListSharedLayout::Header* h = header();
+        const quint32 count = quint32(last - first + 1);
+        if(h == Q_NULLPTR)
+            return;
+        if(h->rowCount + count > h->capacity || quint32(first) > h->rowCount){
+            qDebug()<<"QmlListSharedPublisher"<<__FUNCTION__<<"Error: Capacity exceeded."<<h->capacity;
+            rewrite();
+            return;
+        }
+        begin();
+        void* data = mMemory.data();
+        std::memmove(QmlListSharedLayout::row(data, last + 1), QmlListSharedLayout::row(data, first),
+                     size_t(h->rowCount - quint32(first)) * h->rowSize);
+        h->rowCount += count;
+        writeRows(first, last);
+        push(QmlListSharedLayout::Insert, quint32(first), count);
+        end();
+    }
+
+    void rowsRemoved(int first, int last) override {
+        QmlListSharedLayout::Header* h = header();
+        if(h == Q_NULLPTR)
+            return;
+        if(quint32(last) >= h->rowCount){
+            /**
+              * The removed rows were cut by the capacity
+              */
+            rewrite();
+            return;
+        }
+        begin();
+        void* data = mMemory.data();
+        std::memmove(QmlListSharedLayout::row(data, first), QmlListSharedLayout::row(data, last + 1),
+                     size_t(h->rowCount - quint32(last + 1)) * h->rowSize);
+        h->rowCount -= quint32(last - first + 1);
+        push(QmlListSharedLayout::Remove, quint32(first), quint32(last - first + 1));
+        end();
+    }
+
+    void rowsMoved(int first, int last, int to) override {
+        QmlListSharedLayout::Header* h = header();
+        if(h == Q_NULLPTR)
+            return;
+        const int count = last - first + 1;
+        if(quint32(qMax(last, to + count - 1)) >= h->rowCount){
+            rewrite();
+            return;
+        }
+        begin();
+        void* data = mMemory.data();
+        QByteArray moved(QmlListSharedLayout::row(data, first), count * int(h->rowSize));
+        if(to > first)
+            std::memmove(QmlListSharedLayout::row(data, first), QmlListSharedLayout::row(data, last + 1), size_t(to - first) * h->rowSize);
+        else
+            std::memmove(QmlListSharedLayout::row(data, to + count), QmlListSharedLayout::row(data, to), size_t(first - to) * h->rowSize);
+        std::memcpy(QmlListSharedLayout::row(data, to), moved.constData(), size_t(moved.size()));
+        push(QmlListSharedLayout::Move, quint32(first), quint32(count), quint32(to));
+        end();
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        Q_UNUSED(roles);
+        QmlListSharedLayout::Header* h = header();
+        if(h == Q_NULLPTR || quint32(first) >= h->rowCount)
+            return;
+        last = qMin(last, int(h->rowCount) - 1);
+        begin();
+        writeRows(first, last);
+        push(QmlListSharedLayout::Change, quint32(first), quint32(last - first + 1));
+        end();
+    }
+
+private:
+    inline QmlListSharedLayout::Header* header(){
+        return isAttached() ? QmlListSharedLayout::header(mMemory.data()) : Q_NULLPTR;
+    }
+
+    /**
+      * Seqlock, full barriers on both edges
+      */
+    inline void begin(){
+        header()->sequence.fetchAndAddOrdered(1);
+    }
+
+    inline void end(){
+        header()->sequence.fetchAndAddOrdered(1);
+    }
+
+    inline void push(quint32 operation, quint32 first, quint32 count, quint32 to = 0){
+        QmlListSharedLayout::Header* h = header();
+        QmlListSharedLayout::Operation& o = QmlListSharedLayout::ring(mMemory.data())[h->operations % h->ringCapacity];
+        o.operation = operation;
+        o.first = first;
+        o.count = count;
+        o.to = to;
+        ++h->operations;
+    }
+
+    inline void writeRows(int first, int last){
+        void* data = mMemory.data();
+        const QmlListSharedLayout::Field* fields = QmlListSharedLayout::fields(data);
+        const QMetaObject* metaData = mModel->rowMetaObject();
+        for(int i = first; i <= last; ++i){
+            const QObject* obj = mModel->rowObject(i);
+            char* record = QmlListSharedLayout::row(data, i);
+            for(int f = 0; f < mProperties.size(); ++f)
+                QmlListSharedLayout::writeField(record, fields[f], metaData->property(mProperties.at(f)).read(obj), mStringLength);
+        }
+    }
+
+    /**
+     * @brief rewrite writes all rows, at most the capacity, and tells the readers to reset
+     */
+    void rewrite(){
+        QmlListSharedLayout::Header* h = header();
+        if(h == Q_NULLPTR)
+            return;
+        begin();
+        h->rowCount = quint32(qMin(mModel->rowCount(QModelIndex()), int(h->capacity)));
+        if(h->rowCount > 0)
+            writeRows(0, int(h->rowCount) - 1);
+        push(QmlListSharedLayout::Reset, 0, h->rowCount);
+        end();
+    }
+
+    QAbstractBase*  mModel;
+    QSharedMemory   mMemory;
+    int             mStringLength;
+    QVector<int>    mProperties;
+};
+
+/**
+ * @brief The QmlListSharedModel class reads the rows a QmlListSharedPublisher shares.
+ * data() reads the row records in place, without deserializing a row or a message.
+ * poll(), run by a timer or e.g. on QQuickWindow::frameSwapped, replays the change ring
+ * as model signals. A reader too late for the ring resets.
+ * The roles are Qt::UserRole + the field index, named after the properties.
+ */
+class QmlListSharedModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString key READ key WRITE setKey NOTIFY keyChanged)
+    Q_PROPERTY(bool attached READ isAttached NOTIFY attachedChanged)
+    Q_PROPERTY(int pollInterval READ pollInterval WRITE setPollInterval NOTIFY pollIntervalChanged)
+public:
+    explicit QmlListSharedModel(QObject *parent = 0):
+        QAbstractListModel(parent), mTimer(new QTimer(this)), mRowCount(0), mOperations(0)
+    {
+        mTimer->setInterval(16);
+        connect(mTimer, &QTimer::timeout, this, &QmlListSharedModel::poll);
+    }
+
+    inline QString key() const {
+        return mMemory.key();
+    }
+
+    void setKey(const QString& key){
+        if(mMemory.key() == key)
+            return;
+        detach();
+        mMemory.setKey(key);
+        emit keyChanged();
+        attach();
+    }
+
+    inline bool isAttached() const {
+        return mMemory.isAttached();
+    }
+
+    inline int pollInterval() const {
+        return mTimer->interval();
+    }
+
+    /**
+     * @brief setPollInterval
+     * @param interval Milliseconds, 0 or less to poll only by poll()
+     */
+    void setPollInterval(int interval){
+        if(interval > 0){
+            mTimer->setInterval(interval);
+            if(isAttached())
+                mTimer->start();
+        } else {
+            mTimer->stop();
+        }
+        emit pollIntervalChanged();
+    }
+
+    /**
+     * @brief attach attaches read only to the segment of key()
+     * @return the result of attaching
+     */
+    Q_INVOKABLE bool attach(){
+        if(isAttached())
+            return true;
+        if(!mMemory.attach(QSharedMemory::ReadOnly)){
+            qDebug()<<"QmlListSharedModel"<<__FUNCTION__<<"Error:"<<mMemory.errorString();
+            return false;
+        }
+        /**
+          * The layout is copied once and checked against the mapped size before the field table is read,
+          * the reader then uses the copies only
+          */
+        QmlListSharedLayout::Header h;
+        QVector<QmlListSharedLayout::Field> fields;
+        bool valid = mMemory.size() >= QmlListSharedLayout::align(sizeof(QmlListSharedLayout::Header));
+        if(valid){
+            /**
+              * The sequence is an atomic, which does not copy
+              */
+            std::memcpy(static_cast<void*>(&h), mMemory.constData(), sizeof(h));
+            valid = QmlListSharedLayout::isValid(h, mMemory.size());
+        }
+        if(valid){
+            const QmlListSharedLayout::Field* table = QmlListSharedLayout::fields(mMemory.data());
+            for(quint32 f = 0; valid && f < h.fieldCount; ++f){
+                fields.append(table[f]);
+                valid = QmlListSharedLayout::isValid(fields.last(), h);
+            }
+        }
+        if(!valid){
+            qDebug()<<"QmlListSharedModel"<<__FUNCTION__<<"Error: Wrong format.";
+            mMemory.detach();
+            return false;
+        }
+        beginResetModel();
+        mFields = fields;
+        mRoleNames.clear();
+        for(int f = 0; f < mFields.size(); ++f)
+            mRoleNames.insert(Qt::UserRole + f, QByteArray(mFields.at(f).name));
+        mStringLength = int(h.stringLength);
+        mCapacity = h.capacity;
+        mRingCapacity = h.ringCapacity;
+        mRowSize = h.rowSize;
+        mRing = static_cast<const char*>(mMemory.constData()) + QmlListSharedLayout::align(sizeof(QmlListSharedLayout::Header))
+                + QmlListSharedLayout::align(int(h.fieldCount * sizeof(QmlListSharedLayout::Field)));
+        mRows = mRing + qint64(mRingCapacity) * qint64(sizeof(QmlListSharedLayout::Operation));
+        const bool stable = readState(&mRowCount, &mOperations) && quint32(mRowCount) <= mCapacity;
+        if(!stable){
+            mRowCount = 0;
+            mMemory.detach();
+        }
+        endResetModel();
+        if(!stable)
+            return false;
+        if(pollInterval() > 0)
+            mTimer->start();
+        emit attachedChanged();
+        return true;
+    }
+
+    Q_INVOKABLE void detach(){
+        if(!isAttached())
+            return;
+        mTimer->stop();
+        beginResetModel();
+        mMemory.detach();
+        mRowCount = 0;
+        endResetModel();
+        emit attachedChanged();
+    }
+
+    /**
+     * @brief poll emits the model signals of the operations published since the last poll
+     */
+    Q_INVOKABLE void poll(){
+        if(!isAttached())
+            return;
+        const QmlListSharedLayout::Header* h = QmlListSharedLayout::header(mMemory.data());
+        const QmlListSharedLayout::Operation* ring = reinterpret_cast<const QmlListSharedLayout::Operation*>(mRing);
+        QVector<QmlListSharedLayout::Operation> operations;
+        quint32 rowCount = 0;
+        quint64 head = 0;
+        bool overrun = false;
+        const bool stable = readConsistent([&](){
+            rowCount = h->rowCount;
+            head = h->operations;
+            overrun = head - mOperations > mRingCapacity;
+            operations.clear();
+            for(quint64 k = mOperations; !overrun && k < head; ++k)
+                operations.append(ring[k % mRingCapacity]);
+        });
+        if(!stable)
+            return;
+        if(rowCount > mCapacity){
+            qDebug()<<"QmlListSharedModel"<<__FUNCTION__<<"Error: Wrong row count."<<rowCount<<mCapacity;
+            return;
+        }
+        mOperations = head;
+        if(overrun || !isReplayable(operations)){
+            reset(int(rowCount));
+            return;
+        }
+        for(const QmlListSharedLayout::Operation& o : operations){
+            const int first = int(o.first), last = int(o.first + o.count) - 1;
+            switch(o.operation){
+            case QmlListSharedLayout::Insert:
+                beginInsertRows(QModelIndex(), first, last);
+                mRowCount += int(o.count);
+                endInsertRows();
+                break;
+            case QmlListSharedLayout::Remove:
+                beginRemoveRows(QModelIndex(), first, last);
+                mRowCount -= int(o.count);
+                endRemoveRows();
+                break;
+            case QmlListSharedLayout::Change:
+                emit dataChanged(index(first), index(last));
+                break;
+            case QmlListSharedLayout::Move: {
+                const int to = int(o.to);
+                beginMoveRows(QModelIndex(), first, last, QModelIndex(), to > first ? to + int(o.count) : to);
+                endMoveRows();
+                break;
+            }
+            default:
+                reset(int(o.count));
+                break;
+            }
+        }
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        Q_UNUSED(parent);
+        return mRowCount;
+    }
+
+    /**
+     * @brief data reads the record of the row as the publisher has it now,
+     * which is ahead of the row count until the next poll()
+     */
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        const int f = role - Qt::UserRole;
+        if(!isAttached() || index.row() < 0 || index.row() >= mRowCount || f < 0 || f >= mFields.size())
+            return QVariant();
+        const QmlListSharedLayout::Header* h = QmlListSharedLayout::header(mMemory.constData());
+        QVariant v;
+        const bool stable = readConsistent([&](){
+            v = QVariant();
+            if(quint32(index.row()) < qMin(h->rowCount, mCapacity))
+                v = QmlListSharedLayout::readField(mRows + qint64(index.row()) * mRowSize, mFields.at(f), mStringLength);
+        });
+        return stable ? v : QVariant();
+    }
+
+    QHash<int, QByteArray> roleNames() const override {
+        return mRoleNames;
+    }
+
+signals:
+    void keyChanged();
+    void attachedChanged();
+    void pollIntervalChanged();
+
+private:
+    inline QBasicAtomicInteger<quint32>& sequence() const {
+        return QmlListSharedLayout::header(const_cast<void*>(mMemory.constData()))->sequence;
+    }
+
+    /**
+     * @brief readConsistent runs read under an even sequence until the sequence did not move,
+     * using only loads since the segment is mapped read only. A publisher that stays in a write
+     * or keeps writing for MaxRetries attempts makes the segment unstable and the read fails.
+     * @param read
+     * @return Whether read saw a consistent segment
+     */
+    template<class F>
+    inline bool readConsistent(F read) const {
+        for(int retry = 0; retry < MaxRetries; ++retry){
+            const quint32 s = sequence().loadAcquire();
+            if(s & 1){
+                QThread::yieldCurrentThread();
+                continue;
+            }
+            read();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(sequence().loadAcquire() == s)
+                return true;
+        }
+        qDebug()<<"QmlListSharedModel"<<__FUNCTION__<<"Error: Segment unstable"<<key();
+        return false;
+    }
+
+    inline bool readState(int* rowCount, quint64* operations){
+        const QmlListSharedLayout::Header* h = QmlListSharedLayout::header(mMemory.data());
+        return readConsistent([&](){
+            *rowCount = int(h->rowCount);
+            *operations = h->operations;
+        });
+    }
+
+    static const int MaxRetries = 1000;
+
+    /**
+     * @brief isReplayable
+     * @param operations
+     * @return Whether every operation addresses rows of the row count it applies to, within the capacity
+     */
+    inline bool isReplayable(const QVector<QmlListSharedLayout::Operation>& operations) const {
+        qint64 rowCount = mRowCount;
+        for(const QmlListSharedLayout::Operation& o : operations){
+            const qint64 first = o.first, count = o.count, to = o.to;
+            switch(o.operation){
+            case QmlListSharedLayout::Insert:
+                if(count == 0 || first > rowCount || rowCount + count > mCapacity)
+                    return false;
+                rowCount += count;
+                break;
+            case QmlListSharedLayout::Remove:
+                if(count == 0 || first + count > rowCount)
+                    return false;
+                rowCount -= count;
+                break;
+            case QmlListSharedLayout::Change:
+            case QmlListSharedLayout::Move:
+                if(count == 0 || first + count > rowCount || (o.operation == QmlListSharedLayout::Move && to + count > rowCount))
+                    return false;
+                break;
+            case QmlListSharedLayout::Reset:
+                if(count > mCapacity)
+                    return false;
+                rowCount = count;
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline void reset(int rowCount){
+        beginResetModel();
+        mRowCount = rowCount;
+        endResetModel();
+    }
+
+    QSharedMemory                               mMemory;
+    QTimer*                                     mTimer;
+    QVector<QmlListSharedLayout::Field>         mFields;
+    QHash<int, QByteArray>                      mRoleNames;
+    int                                         mStringLength = 0;
+    quint32                                     mCapacity = 0;
+    quint32                                     mRingCapacity = 0;
+    quint32                                     mRowSize = 0;
+    const char*                                 mRing = Q_NULLPTR;
+    const char*                                 mRows = Q_NULLPTR;
+    int                                         mRowCount;
+    quint64                                     mOperations;
+};
+
+#endif // QMLLISTSHAREDMODEL_H
@@ -0,0 +1,561 @@
+#ifndef QMLLISTSQLSTORE_H
+#define QMLLISTSQLSTORE_H
+
+#include "QmlListModel.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlError>
+#include <limits>
+
+/**
+ * @brief The QmlListSqlWriter class runs the write transactions of a QmlListSqlStore
+ * on its own thread, by its own connection.
+ */
+class QmlListSqlWriter : public QObject
+{
+public:
+    struct Operation {
+        qint64          id;
+        double          position;
+        QVariantList    values;
+        bool            remove;
+    };
+
+    QmlListSqlWriter(const QString& fileName, const QString& table, const QStringList& columns):
+        mFileName(fileName), mTable(table), mColumns(columns),
+        mConnection(QStringLiteral("QmlListSqlWriter_%1").arg(quintptr(this))){}
+
+    ~QmlListSqlWriter(){
+        if(QSqlDatabase::contains(mConnection)){
+            QSqlDatabase::database(mConnection, false).close();
+            QSqlDatabase::removeDatabase(mConnection);
+        }
+    }
+
+    /**
+     * @brief write applies a batch in one transaction
+     * @param batch
+     */
+    void write(const QVector<Operation>& batch){
+        QSqlDatabase db = database();
+        if(!db.isOpen())
+            return;
+        db.transaction();
+        QStringList marks;
+        for(int c = 0; c < mColumns.size() + 2; ++c)
+            marks.append(QStringLiteral("?"));
+        QSqlQuery upsert(db), remove(db);
+        upsert.prepare(QStringLiteral("INSERT OR REPLACE INTO \"%1\" (id, position, \"%2\") VALUES (%3)")
+                       .arg(mTable, mColumns.join(QStringLiteral("\", \"")), marks.join(QStringLiteral(", "))));
+        remove.prepare(QStringLiteral("DELETE FROM \"%1\" WHERE id = ?").arg(mTable));
+        for(const Operation& o : batch){
+            QSqlQuery& q = o.remove ? remove : upsert;
+            q.addBindValue(o.id);
+            if(!o.remove){
+                q.addBindValue(o.position);
+                for(const QVariant& v : o.values)
+                    q.addBindValue(v);
+            }
+            if(!q.exec())
+                qDebug()<<"QmlListSqlWriter"<<__FUNCTION__<<"Error:"<<q.lastError().text();
+        }
+        if(!db.commit())
+            qDebug()<<"QmlListSqlWriter"<<__FUNCTION__<<"Error:"<<db.lastError().text();
+    }
+
+private:
+    QSqlDatabase database(){
+        if(QSqlDatabase::contains(mConnection))
+            return QSqlDatabase::database(mConnection);
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), mConnection);
+        db.setDatabaseName(mFileName);
+        db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=5000"));
+        if(!db.open())
+            qDebug()<<"QmlListSqlWriter"<<__FUNCTION__<<"Error:"<<db.lastError().text();
+        return db;
+    }
+
+    QString     mFileName;
+    QString     mTable;
+    QStringList mColumns;
+    QString     mConnection;
+};
+
+/**
+ * @brief The QmlListSqlStore class persists a model in a SQLite table, one column per property
+ * and one row per model row, ordered by a fractional position.
+ * The changes made through the model API are coalesced per row and written behind,
+ * in one transaction per flush on a background thread, so a flush writes the changed rows only.
+ * open() loads the table lazily through the fetch path of the model, a page at a time, and switches
+ * the database to WAL so the page reads of the model thread do not wait for the writer.
+ * Nested list models are stored as their toBytes blob when UsingSerialize is enabled. The changes
+ * made inside the nested models of the rows are observed and rewrite the blob of their row,
+ * the changes of the models nested deeper are written with the next change of their row.
+ */
+class QmlListSqlStore : public QObject, public QmlListModelObserver
+{
+    Q_OBJECT
+    Q_PROPERTY(int flushInterval READ flushInterval WRITE setFlushInterval NOTIFY flushIntervalChanged)
+public:
+    /**
+     * @brief QmlListSqlStore
+     * @param model The persisted model, empty until open(). It must outlive the store
+     * @param fileName The SQLite database file
+     * @param table
+     * @param parent
+     */
+    QmlListSqlStore(QAbstractBase* model, const QString& fileName, const QString& table, QObject* parent = 0):
+        QObject(parent), mModel(model), mFileName(fileName), mTable(table),
+        mConnection(QStringLiteral("QmlListSqlStore_%1").arg(quintptr(this))),
+        mWriter(Q_NULLPTR), mOpen(false), mNextId(1)
+    {
+        mTimer.setSingleShot(true);
+        mTimer.setInterval(250);
+        connect(&mTimer, &QTimer::timeout, this, [this](){ flush(); });
+        const QMetaObject* metaData = model->rowMetaObject();
+        for(int j = metaData->propertyOffset(); j < metaData->propertyCount(); ++j){
+            const QMetaProperty& p = metaData->property(j);
+#if !UsingSerialize
+            if(QAbstractBase::isSubList(p))
+                continue;
+#endif
+            mProperties.append(j);
+            mColumns.append(QString::fromLatin1(p.name()));
+        }
+    }
+
+    ~QmlListSqlStore(){
+        if(mOpen){
+            mModel->removeObserver(this);
+            mModel->setFetcher(QAbstractBase::Fetcher());
+            flush(true);
+            for(const QVector<NestedWatch*>& watches : mWatches){
+                for(NestedWatch* w : watches)
+                    unwatch(w);
+            }
+            /**
+              * The writer closes its connection on its own thread
+              */
+            QmlListSqlWriter* writer = mWriter;
+            QMetaObject::invokeMethod(writer, [writer](){ delete writer; }, Qt::BlockingQueuedConnection);
+            mThread.quit();
+            mThread.wait();
+        }
+        if(QSqlDatabase::contains(mConnection)){
+            QSqlDatabase::database(mConnection, false).close();
+            QSqlDatabase::removeDatabase(mConnection);
+        }
+    }
+
+    inline int flushInterval() const {
+        return mTimer.interval();
+    }
+
+    /**
+     * @brief setFlushInterval
+     * @param interval Milliseconds the changes are collected before they are written
+     */
+    void setFlushInterval(int interval){
+        mTimer.setInterval(interval);
+        emit flushIntervalChanged();
+    }
+
+    /**
+     * @brief open creates or extends the table, then fetches its rows into the model on demand
+     * @param pageSize Rows fetched per page
+     * @return the result of opening
+     */
+    bool open(int pageSize = 256){
+        if(mOpen)
+            return true;
+        if(mModel->rowCount(QModelIndex()) > 0){
+            qDebug()<<"QmlListSqlStore"<<__FUNCTION__<<"Error: The model is not empty.";
+            return false;
+        }
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), mConnection);
+        db.setDatabaseName(mFileName);
+        db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=5000"));
+        if(!db.open()){
+            qDebug()<<"QmlListSqlStore"<<__FUNCTION__<<"Error:"<<db.lastError().text();
+            return false;
+        }
+        QSqlQuery q(db);
+        if(!q.exec(QStringLiteral("PRAGMA journal_mode=WAL"))
+                || !q.exec(QStringLiteral("CREATE TABLE IF NOT EXISTS \"%1\" (id INTEGER PRIMARY KEY, position REAL NOT NULL)").arg(mTable))
+                || !q.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS \"%1_position\" ON \"%1\" (position)").arg(mTable))){
+            qDebug()<<"QmlListSqlStore"<<__FUNCTION__<<"Error:"<<q.lastError().text();
+            return false;
+        }
+        /**
+          * Add the columns of the properties added since the table was created
+          */
+        const QSqlRecord& record = db.record(mTable);
+        for(const QString& column : mColumns){
+            if(!record.contains(column) && !q.exec(QStringLiteral("ALTER TABLE \"%1\" ADD COLUMN \"%2\"").arg(mTable, column))){
+                qDebug()<<"QmlListSqlStore"<<__FUNCTION__<<"Error:"<<column<<q.lastError().text();
+                return false;
+            }
+        }
+        if(q.exec(QStringLiteral("SELECT MAX(id) FROM \"%1\"").arg(mTable)) && q.next())
+            mNextId = q.value(0).toLongLong() + 1;
+        mWriter = new QmlListSqlWriter(mFileName, mTable, mColumns);
+        mWriter->moveToThread(&mThread);
+        mThread.start();
+        mModel->addObserver(this);
+        mOpen = true;
+        mModel->setFetcher([this](int from, int count){
+            Q_UNUSED(from);
+            return fetch(count);
+        }, pageSize);
+        return true;
+    }
+
+    /**
+     * @brief flush hands the collected changes to the writer thread
+     * @param wait Wait until they are committed
+     */
+    Q_INVOKABLE void flush(bool wait = false){
+        for(QObject* owner : mNested){
+            const int i = mModel->rowIndex(owner);
+            if(i >= 0)
+                record(i);
+        }
+        mNested.clear();
+        mTimer.stop();
+        if(wait)
+            mUnsettled = -std::numeric_limits<double>::infinity();
+        if(mWriter == Q_NULLPTR || (mPending.isEmpty() && !wait))
+            return;
+        QVector<QmlListSqlWriter::Operation> batch;
+        batch.reserve(mPending.size());
+        for(auto it = mPending.constBegin(); it != mPending.constEnd(); ++it)
+            batch.append(it.value());
+        mPending.clear();
+        QmlListSqlWriter* writer = mWriter;
+        QMetaObject::invokeMethod(writer, [writer, batch](){
+            /**
+              * An empty batch only waits for the batches queued before
+              */
+            if(!batch.isEmpty())
+                writer->write(batch);
+        }, wait ? Qt::BlockingQueuedConnection : Qt::QueuedConnection);
+    }
+
+    void rowsInserted(int first, int last) override {
+        const int count = last - first + 1;
+        if(mModel->isFetching()){
+            /**
+              * Rows loaded from the table, their ids and positions come from the fetch
+              */
+            mIds.insert(first, count, 0);
+            mPositions.insert(first, count, 0);
+            for(int i = 0; i < count && !mFetched.isEmpty(); ++i){
+                mIds[first + i] = mFetched.first().first;
+                mPositions[first + i] = mFetched.first().second;
+                mFetched.removeFirst();
+            }
+            watchRows(first, last);
+            return;
+        }
+        mIds.insert(first, count, 0);
+        mPositions.insert(first, count, 0);
+        for(int i = first; i <= last; ++i)
+            mIds[i] = mNextId++;
+        place(first, last);
+        watchRows(first, last);
+    }
+
+    void rowsAboutToBeRemoved(int first, int last) override {
+        for(int i = first; i <= last && i < mIds.size(); ++i){
+            QmlListSqlWriter::Operation o;
+            o.id = mIds.at(i);
+            o.position = mPositions.at(i);
+            o.remove = true;
+            mPending.insert(o.id, o);
+            unsettle(o.position);
+            unwatchOwner(mModel->rowObject(i));
+        }
+        schedule();
+    }
+
+    void rowsRemoved(int first, int last) override {
+        mIds.remove(first, last - first + 1);
+        mPositions.remove(first, last - first + 1);
+    }
+
+    void rowsMoved(int first, int last, int to) override {
+        /**
+          * The moved rows take positions between their new neighbours, the others keep theirs
+          */
+        const int count = last - first + 1;
+        for(int i = first; i <= last; ++i)
+            unsettle(mPositions.at(i));
+        if(to > first){
+            std::rotate(mIds.begin() + first, mIds.begin() + last + 1, mIds.begin() + to + count);
+            std::rotate(mPositions.begin() + first, mPositions.begin() + last + 1, mPositions.begin() + to + count);
+        } else {
+            std::rotate(mIds.begin() + to, mIds.begin() + first, mIds.begin() + last + 1);
+            std::rotate(mPositions.begin() + to, mPositions.begin() + first, mPositions.begin() + last + 1);
+        }
+        place(to, to + count - 1);
+    }
+
+    void rowsAboutToChange(int first, int last, const QVector<int>& roles) override {
+        /**
+          * The rows may be replaced, they are watched again by rowsChanged()
+          */
+        if(!roles.isEmpty())
+            return;
+        for(int i = first; i <= last; ++i)
+            unwatchOwner(mModel->rowObject(i));
+    }
+
+    void rowsChanged(int first, int last, const QVector<int>& roles) override {
+        if(!relevant(roles))
+            return;
+        for(int i = first; i <= last; ++i)
+            record(i);
+        watchRows(first, last);
+    }
+
+
+signals:
+    void flushIntervalChanged();
+
+private:
+    /**
+     * @brief fetch reads the next page by position. The model keeps the order of the positions
+     * and the rows not fetched yet follow all of its rows, so the page starts behind the last row.
+     */
+    QList<QObject*> fetch(int count){
+        QList<QObject*> rows;
+        /**
+          * The rows removed or moved from behind the last row must be gone from there
+          * before reading, the other changes do not touch the page and stay behind
+          */
+        if(mUnsettled > lastPosition(mPositions.size()))
+            flush(true);
+        QSqlQuery q(QSqlDatabase::database(mConnection));
+        q.prepare(QStringLiteral("SELECT id, position, \"%1\" FROM \"%2\" WHERE position > ? ORDER BY position LIMIT ?")
+                  .arg(mColumns.join(QStringLiteral("\", \"")), mTable));
+        q.addBindValue(lastPosition(mPositions.size()));
+        q.addBindValue(count);
+        if(!q.exec()){
+            qDebug()<<"QmlListSqlStore"<<__FUNCTION__<<"Error:"<<q.lastError().text();
+            return rows;
+        }
+        const QMetaObject* metaData = mModel->rowMetaObject();
+        while(q.next()){
+            QObject* obj = mModel->newRow();
+            for(int c = 0; c < mProperties.size(); ++c){
+                const QMetaProperty& p = metaData->property(mProperties.at(c));
+                const QVariant& v = q.value(c + 2);
+                if(v.isNull())
+                    continue;
+                if(QAbstractBase::isSubList(p)){
+#if UsingSerialize
+                    QAbstractBase* list = QAbstractBase::subList(p, obj);
+                    QDataStream s(v.toByteArray());
+                    if(list != Q_NULLPTR)
+                        list->fromBytes(s);
+#endif
+                } else {
+                    p.write(obj, v);
+                }
+            }
+            mFetched.append(qMakePair(q.value(0).toLongLong(), q.value(1).toDouble()));
+            rows.append(obj);
+        }
+        return rows;
+    }
+
+    inline bool relevant(const QVector<int>& roles) const {
+        if(roles.isEmpty())
+            return true;
+        for(int r : roles){
+            if(mProperties.contains(r))
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief record collects the current values of a row, replacing what was collected for it
+     */
+    void record(int i){
+        const QObject* obj = mModel->rowObject(i);
+        if(obj == Q_NULLPTR || i >= mIds.size())
+            return;
+        const QMetaObject* metaData = mModel->rowMetaObject();
+        QmlListSqlWriter::Operation o;
+        o.id = mIds.at(i);
+        o.position = mPositions.at(i);
+        o.remove = false;
+        for(int j : mProperties){
+            const QMetaProperty& p = metaData->property(j);
+            if(QAbstractBase::isSubList(p)){
+#if UsingSerialize
+                QByteArray bytes;
+                QDataStream s(&bytes, QIODevice::WriteOnly);
+                QAbstractBase::writeProperty(s, p, obj);
+                o.values.append(bytes);
+#endif
+            } else {
+                o.values.append(p.read(obj));
+            }
+        }
+        mPending.insert(o.id, o);
+        schedule();
+    }
+
+    /**
+     * @brief lastPosition
+     * @param i
+     * @return The position of the row before i, or the lowest double
+     */
+    inline double lastPosition(int i) const {
+        return i > 0 ? mPositions.at(i - 1) : -std::numeric_limits<double>::max();
+    }
+
+    /**
+     * @brief nextStored
+     * @param after
+     * @return The lowest position of the rows not fetched yet behind after, or infinity
+     */
+    double nextStored(double after){
+        if(!mModel->canFetchMore(QModelIndex()))
+            return std::numeric_limits<double>::infinity();
+        QSqlQuery q(QSqlDatabase::database(mConnection));
+        q.prepare(QStringLiteral("SELECT MIN(position) FROM \"%1\" WHERE position > ?").arg(mTable));
+        q.addBindValue(after);
+        if(q.exec() && q.next() && !q.value(0).isNull())
+            return q.value(0).toDouble();
+        return std::numeric_limits<double>::infinity();
+    }
+
+    /**
+     * @brief place spreads the rows first to last evenly between their neighbours and records them.
+     * When the gap is spent, the range grows until the spacing is representable,
+     * which rewrites the neighbour rows too, rarely.
+     * @param first
+     * @param last
+     */
+    void place(int first, int last){
+        int a = first, b = last;
+        for(;;){
+            const int n = b - a + 1;
+            double lower = a > 0 ? mPositions.at(a - 1) : 0,
+                   upper = b + 1 < mPositions.size() ? mPositions.at(b + 1) : nextStored(lastPosition(a));
+            if(a == 0 && !qIsInf(upper))
+                lower = upper - (n + 1);
+            else if(qIsInf(upper))
+                upper = lower + n + 1;
+            const double step = (upper - lower) / (n + 1);
+            if(lower + step > lower && upper - step < upper && lower + step * n < upper){
+                for(int i = a; i <= b; ++i){
+                    mPositions[i] = lower + step * (i - a + 1);
+                    record(i);
+                }
+                return;
+            }
+            a = qMax(0, a - n);
+            b = qMin(mPositions.size() - 1, b + n);
+        }
+    }
+
+    inline void schedule(){
+        if(!mTimer.isActive())
+            mTimer.start();
+    }
+
+    /**
+     * @brief unsettle records a stored position a row leaves, read again by fetch() until committed
+     */
+    inline void unsettle(double position){
+        mUnsettled = qMax(mUnsettled, position);
+    }
+
+    inline void markNested(QObject* owner){
+        mNested.insert(owner);
+        schedule();
+    }
+
+    /**
+     * @brief The NestedWatch class rewrites the owner row when its nested model changes
+     */
+    struct NestedWatch : public QmlListModelObserver {
+        QmlListSqlStore*            store;
+        QObject*                    owner;
+        QPointer<QAbstractBase>     model;
+
+        void rowsInserted(int, int) override { store->markNested(owner); }
+        void rowsRemoved(int, int) override { store->markNested(owner); }
+        void rowsChanged(int, int, const QVector<int>&) override { store->markNested(owner); }
+        void rowsMoved(int, int, int) override { store->markNested(owner); }
+    };
+
+    void watchRows(int first, int last){
+        const QMetaObject* metaData = mModel->rowMetaObject();
+        for(int i = first; i <= last; ++i){
+            QObject* obj = mModel->rowObject(i);
+            if(obj == Q_NULLPTR)
+                continue;
+            for(int j : mProperties){
+                const QMetaProperty& p = metaData->property(j);
+                QAbstractBase* list = QAbstractBase::isSubList(p) ? QAbstractBase::subList(p, obj) : Q_NULLPTR;
+                if(list != Q_NULLPTR)
+                    watch(obj, list);
+            }
+        }
+    }
+
+    inline void watch(QObject* owner, QAbstractBase* list){
+        QVector<NestedWatch*>& watches = mWatches[owner];
+        for(NestedWatch* w : watches){
+            if(w->model == list)
+                return;
+        }
+        NestedWatch* w = new NestedWatch;
+        w->store = this;
+        w->owner = owner;
+        w->model = list;
+        list->addObserver(w);
+        watches.append(w);
+    }
+
+    inline void unwatch(NestedWatch* w){
+        if(!w->model.isNull())
+            w->model->removeObserver(w);
+        delete w;
+    }
+
+    inline void unwatchOwner(QObject* owner){
+        if(owner == Q_NULLPTR)
+            return;
+        for(NestedWatch* w : mWatches.take(owner))
+            unwatch(w);
+        mNested.remove(owner);
+    }
+
+    QAbstractBase*                                  mModel;
+    QString                                         mFileName;
+    QString                                         mTable;
+    QString                                         mConnection;
+    QVector<int>                                    mProperties;
+    QStringList                                     mColumns;
+    QThread                                         mThread;
+    QmlListSqlWriter*                               mWriter;
+    QTimer                                          mTimer;
+    bool                                            mOpen;
+    qint64                                          mNextId;
+    QVector<qint64>                                 mIds;
+    QVector<double>                                 mPositions;
+    QList<QPair<qint64, double> >                   mFetched;
+    QHash<qint64, QmlListSqlWriter::Operation>      mPending;
+    QSet<QObject*>                                  mNested;
+    QHash<QObject*, QVector<NestedWatch*> >         mWatches;
+    double                                          mUnsettled = -std::numeric_limits<double>::infinity();
+};
+
+#endif // QMLLISTSQLSTORE_H
@@ -0,0 +1,625 @@
+#ifndef QMLSTRUCTLISTMODEL_H
+#define QMLSTRUCTLISTMODEL_H
+
+#include "QmlListModel.h"
+
+/**
+  * Describes a plain struct by an X-macro listing its fields as F(Type, Name), e.g.
+  *
+  * #define POINT_FIELDS(F) F(int, x) F(int, y) F(QString, label)
+  * struct Point { POINT_FIELDS(QML_STRUCT_MEMBER) };
+  * QML_STRUCT(Point, POINT_FIELDS)
+  *
+  * QML_STRUCT is used at global scope. The roles are Qt::UserRole + the field index, in order.
+  * A type containing a comma, e.g. QMap<QString, int>, is declared by a typedef first.
+  */
+#define QML_STRUCT_MEMBER(Type, Name) Type Name;
+
+/**
+  * API for Javascript side of a QmlStructListModel.
+  */
+#define QML_STRUCT_LIST_MODEL QML_LIST_MODEL_API
+
+template<typename S>
+struct QmlStructTraits;
+
+/**
+ * @brief qmlStructAssign writes a QVariant into a field
+ * @param field
+ * @param value
+ * @return Whether the value converts to the field type
+ */
+template<typename V>
+inline bool qmlStructAssign(V& field, const QVariant& value)
+{
+    if(!value.canConvert<V>())
+        return false;
+    field = value.value<V>();
+    return true;
+}
+
+/**
+ * @brief The QmlStructField class is the typed role of one struct field,
+ * used as QmlStructListModel::value<Field::x>(i) like the roles of QML_LIST_ROLE.
+ */
+template<typename S, typename V, V S::*Member, int Role>
+struct QmlStructField
+{
+    typedef V Type;
+
+    static inline int role(){
+        return Role;
+    }
+
+    static inline const V& get(const S& s){
+        return s.*Member;
+    }
+
+    static inline V& ref(S& s){
+        return s.*Member;
+    }
+
+    static inline QVariant read(const S& s){
+        return QVariant::fromValue(s.*Member);
+    }
+
+    static inline bool write(S& s, const QVariant& value){
+        return qmlStructAssign(s.*Member, value);
+    }
+};
+
+#define QML_STRUCT_ROLE_(Type, Name) Name##Role,
+#define QML_STRUCT_FIELD_(Type, Name) typedef QmlStructField<Struct, Type, &Struct::Name, Name##Role> Name;
+#define QML_STRUCT_NAME_(Type, Name) #Name,
+#define QML_STRUCT_READ_(Type, Name) &Field::Name::read,
+#define QML_STRUCT_WRITE_(Type, Name) &Field::Name::write,
+#define QML_STRUCT_SAVE_(Type, Name) qmlStream << qmlRow.Name;
+#define QML_STRUCT_LOAD_(Type, Name) qmlStream >> qmlRow.Name;
+#define QML_STRUCT_TO_MAP_(Type, Name) qmlMap.insert(QStringLiteral(#Name), QVariant::fromValue(qmlRow.Name));
+#define QML_STRUCT_FROM_MAP_(Type, Name) \
+    if(qmlMap.contains(QStringLiteral(#Name))) \
+        qmlStructAssign(qmlRow.Name, qmlMap.value(QStringLiteral(#Name)));
+
+/**
+  * Generates QmlStructTraits<S> from the field list: the role enum, the typed fields,
+  * the per-field read/write tables and the unrolled stream and map conversions.
+  */
+#define QML_STRUCT(S, FIELDS) \
+template<> \
+struct QmlStructTraits<S> \
+{ \
+    typedef S Struct; \
+    enum Roles { QmlStructFirstRole = Qt::UserRole - 1, FIELDS(QML_STRUCT_ROLE_) QmlStructEndRole }; \
+    enum { FieldCount = QmlStructEndRole - Qt::UserRole }; \
+    struct Field { FIELDS(QML_STRUCT_FIELD_) }; \
+    static inline const char* fieldName(int f){ \
+        static const char* const names[] = { FIELDS(QML_STRUCT_NAME_) }; \
+        return names[f]; \
+    } \
+    static inline QVariant readField(const S& qmlRow, int f){ \
+        static QVariant (* const readers[])(const S&) = { FIELDS(QML_STRUCT_READ_) }; \
+        return readers[f](qmlRow); \
+    } \
+    static inline bool writeField(S& qmlRow, int f, const QVariant& value){ \
+        static bool (* const writers[])(S&, const QVariant&) = { FIELDS(QML_STRUCT_WRITE_) }; \
+        return writers[f](qmlRow, value); \
+    } \
+    static inline void save(QDataStream& qmlStream, const S& qmlRow){ FIELDS(QML_STRUCT_SAVE_) } \
+    static inline void load(QDataStream& qmlStream, S& qmlRow){ FIELDS(QML_STRUCT_LOAD_) } \
+    static inline QVariantMap toMap(const S& qmlRow){ \
+        QVariantMap qmlMap; \
+        FIELDS(QML_STRUCT_TO_MAP_) \
+        return qmlMap; \
+    } \
+    static inline void fromMap(S& qmlRow, const QVariantMap& qmlMap){ FIELDS(QML_STRUCT_FROM_MAP_) } \
+};
+
+template<typename S>
+/**
+ * @brief The QmlStructListModel class is a list model of plain structs described by QML_STRUCT.
+ * The rows are stored by value in one QVector, without a QObject or moc per row type,
+ * and the roles, data(), setData() and the serialization are generated at compile time.
+ * The subclass adds Q_OBJECT and QML_STRUCT_LIST_MODEL, the API of QML_LIST_MODEL without
+ * aggregate() and stats, which observe QObject rows. The rows cross to JavaScript as objects
+ * of their fields: get(i) returns a copy, written back by set(i, row).
+ * @author Jiu
+ */
+class QmlStructListModel : public QAbstractListModel
+{
+public:
+    typedef QmlStructTraits<S> Traits;
+    typedef typename Traits::Field Field;
+
+    inline explicit QmlStructListModel(QObject *parent = 0):
+        QAbstractListModel(parent){}
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : mData.count();
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        const unsigned f = unsigned(role - Qt::UserRole);
+        if (index.row() < 0 || index.row() >= mData.count() || f >= unsigned(Traits::FieldCount))
+            return QVariant();
+        return Traits::readField(mData.at(index.row()), f);
+    }
+
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+
+    QHash<int, QByteArray> roleNames() const override;
+
+    /**
+     * @brief rows
+     * @return The rows, contiguous
+     */
+    inline const QVector<S>& rows() const {
+        return mData;
+    }
+
+    inline const S& getData(int i) const {
+        return mData.at(i);
+    }
+
+    /**
+     * @brief appendData
+     * @param row
+     */
+    void appendData(const S& row);
+
+    /**
+     * @brief appendData appends the rows by one insertion
+     * @param rows
+     */
+    void appendData(const QVector<S>& rows);
+
+    /**
+     * @brief insertData
+     * @param i
+     * @param row
+     * @return
+     */
+    bool insertData(int i, const S& row);
+
+    /**
+     * @brief setData replaces row i, notifying all roles
+     * @param i
+     * @param row
+     * @return
+     */
+    bool setData(int i, const S& row);
+
+    /**
+     * @brief removeData
+     * @param i
+     * @return
+     */
+    inline bool removeData(int i){
+        return removeData(i, 1);
+    }
+
+    /**
+     * @brief removeData removes count rows by one removal
+     * @param first
+     * @param count
+     * @return
+     */
+    bool removeData(int first, int count);
+
+    /**
+     * @brief moveData moves count rows from to to, counted after the move
+     * @param from
+     * @param to
+     * @param count
+     * @return
+     */
+    bool moveData(int from, int to, int count = 1);
+
+    void clear();
+
+    /**
+     * @brief value reads one field of row i, inlined to a member access
+     * @return
+     */
+    template<typename F>
+    inline const typename F::Type& value(int i) const {
+        return F::get(mData.at(i));
+    }
+
+    /**
+     * @brief setValue writes one field of row i, notifying only its role
+     * @param i
+     * @param v
+     * @return
+     */
+    template<typename F>
+    bool setValue(int i, const typename F::Type& v);
+
+    /**
+     * @brief values
+     * @return The values of one field
+     */
+    template<typename F>
+    QVector<typename F::Type> values() const;
+
+#if UsingSerialize
+    /**
+     * @brief serialize
+     * @return Serialized data
+     */
+    inline QByteArray serialize(){
+        QByteArray buffer;
+        QDataStream stream(&buffer, QIODevice::WriteOnly);
+        toBytes(stream);
+        return buffer;
+    }
+
+    /**
+     * @brief unserialize
+     * @param data
+     */
+    inline void unserialize(QByteArray data){
+        QDataStream stream(&data, QIODevice::ReadOnly);
+        fromBytes(stream);
+    }
+
+    /**
+     * @brief toBytes writes the row count and then the fields of every row, unrolled per field
+     * @param s
+     */
+    void toBytes(QDataStream& s);
+
+    void fromBytes(QDataStream& s);
+#endif
+
+#if UsingJson
+    /**
+     * @brief toJson
+     * @return An array of objects of the fields
+     */
+    QJsonArray toJson();
+
+    bool fromJson(QJsonArray array);
+#endif
+
+protected:
+    /**
+     * @brief create_
+     * @return A default row
+     */
+    static inline QVariant create_(){
+        return Traits::toMap(S());
+    }
+
+    inline QVariant get_(int i) const {
+        if (i < 0 || i >= mData.count())
+            return QVariant();
+        return Traits::toMap(mData.at(i));
+    }
+
+    inline void append_(QVariant data){
+        S row = S();
+        Traits::fromMap(row, data.toMap());
+        appendData(row);
+    }
+
+    inline bool insert_(int i, QVariant data){
+        S row = S();
+        Traits::fromMap(row, data.toMap());
+        return insertData(i, row);
+    }
+
+    /**
+     * @brief set_ writes the fields present in data, the others keep their value
+     * @param i
+     * @param data
+     * @return
+     */
+    inline bool set_(int i, QVariant data){
+        if (i < 0 || i >= mData.count())
+            return false;
+        S row = mData.at(i);
+        Traits::fromMap(row, data.toMap());
+        return setData(i, row);
+    }
+
+    /**
+     * @brief share_ copies row i into other, the rows are values
+     * @param i
+     * @param other A model of the same row type
+     * @param j
+     * @return
+     */
+    inline bool share_(int i, QObject* other, int j){
+        QmlStructListModel<S>* model = dynamic_cast<QmlStructListModel<S>*>(other);
+        if (i < 0 || i >= mData.count() || model == Q_NULLPTR)
+            return false;
+        return model->insertData(j < 0 ? model->mData.count() : j, mData.at(i));
+    }
+
+    QVariantList getRange_(int from, int count, const QStringList& roles) const;
+
+    QVariantList column_(const QString& role) const;
+
+    void forEach_(QJSValue callback);
+
+    /**
+     * @brief setViewport_ checks the viewport and caches nothing,
+     * data() already reads a field of a contiguous struct
+     */
+    inline void setViewport_(int first, int last, const QStringList& roles){
+        if(first < 0 || last < first){
+            qDebug()<<"QmlStructListModel"<<__FUNCTION__<<"Error: Wrong viewport."<<first<<last;
+            return;
+        }
+        for(const QString& role : roles){
+            if(fieldIndex(role) < 0)
+                qDebug()<<"QmlStructListModel"<<__FUNCTION__<<"Error: Wrong role."<<role;
+        }
+        if(last >= mData.count() - 1 && canFetchMore(QModelIndex()))
+            fetchMore(QModelIndex());
+    }
+
+    /**
+     * @brief fieldIndex
+     * @param name
+     * @return The field of the role name, -1 if none
+     */
+    static inline int fieldIndex(const QString& name){
+        for(int f = 0; f < Traits::FieldCount; ++f){
+            if(name == QLatin1String(Traits::fieldName(f)))
+                return f;
+        }
+        return -1;
+    }
+
+    QVector<S> mData;
+};
+
+template<typename S>
+bool QmlStructListModel<S>::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    const unsigned f = unsigned(role - Qt::UserRole);
+    if (index.row() < 0 || index.row() >= mData.count() || f >= unsigned(Traits::FieldCount))
+        return false;
+    if (!Traits::writeField(mData[index.row()], f, value))
+        return false;
+    emit dataChanged(index, index, QVector<int>(1, role));
+    return true;
+}
+
+template<typename S>
+QHash<int, QByteArray> QmlStructListModel<S>::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    for(int f = 0; f < Traits::FieldCount; ++f)
+        roles.insert(Qt::UserRole + f, Traits::fieldName(f));
+    return roles;
+}
+
+template<typename S>
+void QmlStructListModel<S>::appendData(const S &row)
+{
+    beginInsertRows(QModelIndex(), mData.count(), mData.count());
+    mData.append(row);
+    endInsertRows();
+}
+
+template<typename S>
+void QmlStructListModel<S>::appendData(const QVector<S> &rows)
+{
+    if (rows.isEmpty())
+        return;
+    beginInsertRows(QModelIndex(), mData.count(), mData.count() + rows.count() - 1);
+    mData += rows;
+    endInsertRows();
+}
+
+template<typename S>
+bool QmlStructListModel<S>::insertData(int i, const S &row)
+{
+    if (i < 0 || i > mData.count())
+        return false;
+    beginInsertRows(QModelIndex(), i, i);
+    mData.insert(i, row);
+    endInsertRows();
+    return true;
+}
+
+template<typename S>
+bool QmlStructListModel<S>::setData(int i, const S &row)
+{
+    if (i < 0 || i >= mData.count())
+        return false;
+    mData[i] = row;
+    emit dataChanged(index(i), index(i));
+    return true;
+}
+
+template<typename S>
+bool QmlStructListModel<S>::removeData(int first, int count)
+{
+    if (first < 0 || count < 0 || first + count > mData.count())
+        return false;
+    if (count == 0)
+        return true;
+    beginRemoveRows(QModelIndex(), first, first + count - 1);
+    mData.remove(first, count);
+    endRemoveRows();
+    return true;
+}
+
+template<typename S>
+bool QmlStructListModel<S>::moveData(int from, int to, int count)
+{
+    if (count <= 0 || from < 0 || to < 0 || from + count > mData.count() || to + count > mData.count())
+        return false;
+    if (from == to)
+        return true;
+    if (!beginMoveRows(QModelIndex(), from, from + count - 1, QModelIndex(), to > from ? to + count : to))
+        return false;
+    if (to > from)
+        std::rotate(mData.begin() + from, mData.begin() + from + count, mData.begin() + to + count);
+    else
+        std::rotate(mData.begin() + to, mData.begin() + from, mData.begin() + from + count);
+    endMoveRows();
+    return true;
+}
+
+template<typename S>
+void QmlStructListModel<S>::clear()
+{
+    if (mData.isEmpty())
+        return;
+    beginResetModel();
+    mData.clear();
+    endResetModel();
+}
+
+template<typename S>
+template<typename F>
+bool QmlStructListModel<S>::setValue(int i, const typename F::Type& v)
+{
+    if (i < 0 || i >= mData.count())
+        return false;
+    if (F::get(mData.at(i)) == v)
+        return true;
+    F::ref(mData[i]) = v;
+    emit dataChanged(index(i), index(i), QVector<int>(1, F::role()));
+    return true;
+}
+
+template<typename S>
+template<typename F>
+QVector<typename F::Type> QmlStructListModel<S>::values() const
+{
+    QVector<typename F::Type> values;
+    values.reserve(mData.count());
+    for(const S& row : mData)
+        values.append(F::get(row));
+    return values;
+}
+
+#if UsingSerialize
+template<typename S>
+void QmlStructListModel<S>::toBytes(QDataStream &s)
+{
+    s << quint32(mData.size());
+    for(const S& row : mData)
+        Traits::save(s, row);
+}
+
+template<typename S>
+void QmlStructListModel<S>::fromBytes(QDataStream &s)
+{
+    quint32 c;
+    s >> c;
+    QVector<S> rows;
+    /**
+      * A row is at least one byte, so the count never reserves more than the stream holds
+      */
+    if (s.device() != Q_NULLPTR)
+        rows.reserve(int(qMin<qint64>(c, s.device()->bytesAvailable())));
+    for(quint32 i = 0; i < c && s.status() == QDataStream::Ok; ++i) {
+        S row = S();
+        Traits::load(s, row);
+        rows.append(row);
+    }
+    if (s.status() != QDataStream::Ok || quint32(rows.count()) != c) {
+        qDebug()<<"QmlStructListModel"<<__FUNCTION__<<"Error: Corrupt data.";
+        return;
+    }
+    beginResetModel();
+    mData.swap(rows);
+    endResetModel();
+}
+#endif
+
+#if UsingJson
+template<typename S>
+QJsonArray QmlStructListModel<S>::toJson()
+{
+    QJsonArray array;
+    for(const S& row : mData)
+        array.append(QJsonObject::fromVariantMap(Traits::toMap(row)));
+    return array;
+}
+
+template<typename S>
+bool QmlStructListModel<S>::fromJson(QJsonArray array)
+{
+    QVector<S> rows;
+    rows.reserve(array.size());
+    for(int i = 0; i < array.size(); ++i) {
+        if (!array.at(i).isObject()) {
+            qDebug()<<"QmlStructListModel"<<__FUNCTION__<<"Error: Not an object."<<i;
+            return false;
+        }
+        S row = S();
+        Traits::fromMap(row, array.at(i).toObject().toVariantMap());
+        rows.append(row);
+    }
+    beginResetModel();
+    mData.swap(rows);
+    endResetModel();
+    return true;
+}
+#endif
+
+template<typename S>
+QVariantList QmlStructListModel<S>::getRange_(int from, int count, const QStringList &roles) const
+{
+    QVariantList rows;
+    const int last = int(qMin<qint64>(mData.count(), qint64(from) + count));
+    if (from < 0 || from >= last)
+        return rows;
+    QVector<int> fields;
+    for(const QString& role : roles){
+        const int f = fieldIndex(role);
+        if (f >= 0)
+            fields.append(f);
+    }
+    rows.reserve(last - from);
+    for(int i = from; i < last; ++i){
+        if (roles.isEmpty()) {
+            rows.append(Traits::toMap(mData.at(i)));
+            continue;
+        }
+        QVariantMap row;
+        for(int f : fields)
+            row.insert(QString::fromLatin1(Traits::fieldName(f)), Traits::readField(mData.at(i), f));
+        rows.append(row);
+    }
+    return rows;
+}
+
+template<typename S>
+QVariantList QmlStructListModel<S>::column_(const QString &role) const
+{
+    QVariantList values;
+    const int f = fieldIndex(role);
+    if (f < 0)
+        return values;
+    values.reserve(mData.count());
+    for(const S& row : mData)
+        values.append(Traits::readField(row, f));
+    return values;
+}
+
+template<typename S>
+void QmlStructListModel<S>::forEach_(QJSValue callback)
+{
+    QJSEngine* engine = qjsEngine(this);
+    if (engine == Q_NULLPTR || !callback.isCallable())
+        return;
+    for(int i = 0; i < mData.count(); ++i){
+        const QJSValue& r = callback.call(QJSValueList() << engine->toScriptValue(Traits::toMap(mData.at(i))) << i);
+        if (r.isError()) {
+            qDebug()<<"QmlStructListModel"<<__FUNCTION__<<"Error:"<<r.toString();
+            return;
+        }
+        if (r.isBool() && !r.toBool())
+            return;
+    }
+}
+
+#endif // QMLSTRUCTLISTMODEL_H
@@ -0,0 +1,23 @@
+TEMPLATE = app
+
+TARGET = QmlListModelBench
+
+QT += qml testlib
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += UsingSerialize=1 UsingJson=1
+
+INCLUDEPATH += ../QmlListModelDemo ..
+
+SOURCES += bench_model.cpp
+
+HEADERS += \
+    ../QmlListModelDemo/CompanyModel.h \
+    ../QmlListModelDemo/QmlListModel.h \
+    ../QmlListModelDemo/MemberModel.h \
+    ../QmlStructListModel.h
+
+QMAKE_CXXFLAGS += -std=c++11
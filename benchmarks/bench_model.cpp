@@ -0,0 +1,609 @@
+#include <QtTest>
+#include <QXmlStreamReader>
+#include <QQmlEngine>
+#include <limits>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "CompanyModel.h"
+#include "QmlStructListModel.h"
+
+/**
+  * Rows of the nested MemberModel of every Apartment
+  */
+static const int NestedRows = 3;
+
+/**
+  * Rows changed by the per-row benchmarks
+  */
+static const int Operations = 1000;
+
+static Member* newRow(Member*, int i)
+{
+    return new Member(QStringLiteral("Member %1").arg(i));
+}
+
+static Apartment* newRow(Apartment*, int i)
+{
+    MemberModel* members = new MemberModel;
+    for(int j = 0; j < NestedRows; ++j)
+        members->appendData(new Member(QStringLiteral("Member %1.%2").arg(i).arg(j)));
+    return new Apartment(QStringLiteral("Apartment %1").arg(i), members);
+}
+
+template<typename T>
+static QList<T*> newRows(int count)
+{
+    QList<T*> rows;
+    rows.reserve(count);
+    for(int i = 0; i < count; ++i)
+        rows.append(newRow(static_cast<T*>(Q_NULLPTR), i));
+    return rows;
+}
+
+template<typename M, typename T>
+static void fill(M& model, int count)
+{
+    model.appendData(newRows<T>(count));
+}
+
+/**
+  * Runs f<MemberModel, Member> or f<CompanyModel, Apartment> by the "type" column
+  */
+#define BENCH_DISPATCH(f) \
+    QFETCH(QString, type); \
+    QFETCH(int, rows); \
+    if(type == QLatin1String("Member")) \
+        f<MemberModel, Member>(rows); \
+    else \
+        f<CompanyModel, Apartment>(rows);
+
+template<typename M, typename T>
+static void benchAppendData(int count)
+{
+    M model;
+    const QList<T*>& rows = newRows<T>(count);
+    QBENCHMARK_ONCE {
+        for(T* t : rows)
+            model.appendData(t);
+    }
+}
+
+template<typename M, typename T>
+static void benchInsertData(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    const QList<T*>& rows = newRows<T>(Operations);
+    QBENCHMARK_ONCE {
+        for(T* t : rows)
+            model.insertData(count / 2, t);
+    }
+}
+
+template<typename M, typename T>
+static void benchRemoveData(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    const int removed = qMin(count, Operations);
+    QBENCHMARK_ONCE {
+        for(int i = 0; i < removed; ++i)
+            model.removeData((count - i) / 2);
+    }
+}
+
+template<typename M, typename T>
+static void benchSetData(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    const QList<T*>& rows = newRows<T>(Operations);
+    QBENCHMARK_ONCE {
+        for(int i = 0; i < rows.size(); ++i)
+            model.setData(int(qint64(i) * count / rows.size()), rows.at(i));
+    }
+}
+
+template<typename M, typename T>
+static void benchData(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    QAbstractItemModel& itemModel = model;
+    const QList<int>& roles = itemModel.roleNames().keys();
+    QBENCHMARK {
+        for(int i = 0; i < Operations; ++i){
+            const QModelIndex& index = itemModel.index(int(qint64(i) * count / Operations), 0);
+            for(int role : roles)
+                itemModel.data(index, role);
+        }
+    }
+}
+
+template<typename M, typename T>
+static void benchRoleNames(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    QAbstractItemModel& itemModel = model;
+    QBENCHMARK {
+        itemModel.roleNames();
+    }
+}
+
+template<typename M, typename T>
+static void benchClear(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    QBENCHMARK_ONCE {
+        model.clear();
+    }
+}
+
+template<typename M, typename T>
+static void benchCloneData(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    QBENCHMARK {
+        for(int i = 0; i < Operations; ++i)
+            delete M::cloneData(model.getData(int(qint64(i) * count / Operations)));
+    }
+}
+
+template<typename M, typename T>
+static void benchToJson(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    QBENCHMARK_ONCE {
+        model.toJson();
+    }
+}
+
+template<typename M, typename T>
+static void benchFromJson(int count)
+{
+    M model, source;
+    fill<M, T>(source, count);
+    const QJsonArray& array = source.toJson();
+    QBENCHMARK_ONCE {
+        model.fromJson(array);
+    }
+}
+
+template<typename M, typename T>
+static void benchToBytes(int count)
+{
+    M model;
+    fill<M, T>(model, count);
+    QBENCHMARK_ONCE {
+        model.serialize();
+    }
+}
+
+template<typename M, typename T>
+static void benchFromBytes(int count)
+{
+    M model, source;
+    fill<M, T>(source, count);
+    const QByteArray& bytes = source.serialize();
+    QBENCHMARK_ONCE {
+        model.unserialize(bytes);
+    }
+}
+
+template<typename M, typename T>
+static void benchFromBytesSchema(int count)
+{
+    M model, source;
+    fill<M, T>(source, count);
+    const QByteArray& bytes = source.toBytesSchema();
+    QBENCHMARK_ONCE {
+        model.fromBytesSchema(bytes, true);
+    }
+}
+
+/**
+  * The Member row as a plain struct, for data() without the meta object
+  */
+#define MEMBER_RECORD_FIELDS(F) F(QString, memberName)
+struct MemberRecord { MEMBER_RECORD_FIELDS(QML_STRUCT_MEMBER) };
+QML_STRUCT(MemberRecord, MEMBER_RECORD_FIELDS)
+
+class MemberRecordModel : public QmlStructListModel<MemberRecord>
+{
+    Q_OBJECT
+    QML_STRUCT_LIST_MODEL
+};
+
+static void benchStructData(int count)
+{
+    MemberRecordModel model;
+    QVector<MemberRecord> rows(count);
+    for(int i = 0; i < count; ++i)
+        rows[i].memberName = QStringLiteral("Member %1").arg(i);
+    model.appendData(rows);
+    QAbstractItemModel& itemModel = model;
+    const QList<int>& roles = itemModel.roleNames().keys();
+    QBENCHMARK {
+        for(int i = 0; i < Operations; ++i){
+            const QModelIndex& index = itemModel.index(int(qint64(i) * count / Operations), 0);
+            for(int role : roles)
+                itemModel.data(index, role);
+        }
+    }
+}
+
+/**
+  * Rows read from JavaScript by the jsRead benchmarks
+  */
+static const int JsRows = 50000;
+
+/**
+  * Reads memberName of every row from JavaScript, row by row, in pages or by forEach
+  */
+static const char* const JsReaders[] = {
+    "(function(){ var n = 0;"
+    "  for(var i = 0; i < members.size(); i++)"
+    "    n += members.get(i).memberName.length;"
+    "  return n; })",
+    "(function(){ var n = 0, size = members.size();"
+    "  for(var first = 0; first < size; first += 1000){"
+    "    var rows = members.getRange(first, 1000, [\"memberName\"]);"
+    "    for(var k = 0; k < rows.length; k++)"
+    "      n += rows[k].memberName.length;"
+    "  }"
+    "  return n; })",
+    "(function(){ var n = 0;"
+    "  members.forEach(function(row){ n += row.memberName.length; });"
+    "  return n; })"
+};
+
+/**
+ * @brief The JsBench class holds a QQmlEngine exposing a 50k row MemberModel as "members"
+ */
+class JsBench
+{
+public:
+    JsBench(){
+        fill<MemberModel, Member>(mModel, JsRows);
+        QQmlEngine::setObjectOwnership(&mModel, QQmlEngine::CppOwnership);
+        mEngine.globalObject().setProperty(QStringLiteral("members"), mEngine.newQObject(&mModel));
+        for(const char* reader : JsReaders)
+            mReaders.append(mEngine.evaluate(QString::fromLatin1(reader)));
+    }
+
+    /**
+     * @brief read runs one reader over all rows
+     * @param reader 0 get(), 1 getRange(), 2 forEach()
+     * @return The total length read, the same for every reader
+     */
+    inline int read(int reader){
+        const QJSValue& r = mReaders[reader].call();
+        if(r.isError())
+            qWarning()<<"QmlListModelBench"<<"Error:"<<r.toString();
+        return r.toInt();
+    }
+
+    /**
+     * @brief time
+     * @param reader
+     * @return The best of three runs, in nanoseconds
+     */
+    inline qint64 time(int reader){
+        qint64 best = std::numeric_limits<qint64>::max();
+        for(int run = 0; run < 3; ++run){
+            QElapsedTimer timer;
+            timer.start();
+            read(reader);
+            best = qMin(best, timer.nsecsElapsed());
+        }
+        return qMax<qint64>(best, 1);
+    }
+
+private:
+    MemberModel     mModel;
+    QQmlEngine      mEngine;
+    QList<QJSValue> mReaders;
+};
+
+/**
+ * @brief The BenchModel class measures the QmlListModel hot paths
+ * at 1k/100k/1M rows of Member and Apartment.
+ * QMLLISTMODEL_BENCH_MAX_ROWS caps the sizes on small machines.
+ */
+class BenchModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup(){
+        /**
+          * The removed rows are deleted later, release them between the benchmarks
+          */
+        QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+    }
+
+    void appendData_data(){ rows(); }
+    void appendData(){ BENCH_DISPATCH(benchAppendData) }
+
+    void insertData_data(){ rows(); }
+    void insertData(){ BENCH_DISPATCH(benchInsertData) }
+
+    void removeData_data(){ rows(); }
+    void removeData(){ BENCH_DISPATCH(benchRemoveData) }
+
+    void setData_data(){ rows(); }
+    void setData(){ BENCH_DISPATCH(benchSetData) }
+
+    void data_data(){ rows(); }
+    void data(){ BENCH_DISPATCH(benchData) }
+
+    /**
+      * 100k appends into a 10k row window, flushed every 1000 rows like event loop turns
+      */
+    void appendWindowed(){
+        MemberModel model;
+        model.setWindow(10000);
+        int n = 0;
+        QBENCHMARK {
+            for(int i = 0; i < 100000; ++i){
+                Member* row = model.recycledRow();
+                row->mName = QStringLiteral("Member %1").arg(n++);
+                model.appendWindowed(row);
+                if(i % 1000 == 999)
+                    model.flushWindow();
+            }
+            model.flushWindow();
+        }
+    }
+
+    /**
+      * 50k rows read from JavaScript by get(), getRange() and forEach()
+      */
+    void jsRead_data(){
+        QTest::addColumn<int>("reader");
+        QTest::newRow("get") << 0;
+        QTest::newRow("getRange") << 1;
+        QTest::newRow("forEach") << 2;
+    }
+
+    void jsRead(){
+        QFETCH(int, reader);
+        JsBench bench;
+        QBENCHMARK {
+            bench.read(reader);
+        }
+    }
+
+    /**
+      * The batched reads must beat get() per row by 10 times or more
+      */
+    void jsReadSpeedup(){
+        JsBench bench;
+        QCOMPARE(bench.read(1), bench.read(0));
+        QCOMPARE(bench.read(2), bench.read(0));
+        const qint64 get = bench.time(0), getRange = bench.time(1), forEach = bench.time(2);
+        qDebug()<<"QmlListModelBench"<<"getRange"<<double(get) / getRange<<"x, forEach"<<double(get) / forEach<<"x";
+        QVERIFY2(get >= 10 * getRange, "getRange() is less than 10 times faster than get().");
+        QVERIFY2(get >= 10 * forEach, "forEach() is less than 10 times faster than get().");
+    }
+
+    /**
+      * A patch recorded on a model with nested models brings a mirror to the same bytes,
+      * a truncated patch leaves the mirror and its revision unchanged
+      */
+    void patchRoundTrip(){
+        CompanyModel source;
+        fill<CompanyModel, Apartment>(source, 10);
+        source.setPatchRecording(true);
+        CompanyModel mirror;
+        mirror.unserialize(source.serialize());
+        mirror.setPatchRevision(source.patchRevision());
+
+        source.appendData(newRow(static_cast<Apartment*>(Q_NULLPTR), 10));
+        source.insertData(2, newRow(static_cast<Apartment*>(Q_NULLPTR), 11));
+        source.removeData(0);
+        source.moveData(0, 5, 2);
+        source.setValue<ApartmentNameRole>(3, QStringLiteral("Renamed"));
+        source.setData(4, newRow(static_cast<Apartment*>(Q_NULLPTR), 12));
+        source.getData(1)->mMembers->appendData(new Member(QStringLiteral("Nested")));
+        source.getData(6)->mMembers->removeData(0);
+        source.getData(6)->mMembers->setValue<MemberNameRole>(0, QStringLiteral("Nested renamed"));
+        QVERIFY(mirror.applyPatch(source.takePatch()));
+        QCOMPARE(mirror.serialize(), source.serialize());
+        QCOMPARE(mirror.patchRevision(), source.patchRevision());
+
+        source.getData(0)->mMembers->moveData(0, 1);
+        source.removeData(8);
+        const QByteArray& patch = source.takePatch();
+        const QByteArray before = mirror.serialize();
+        QVERIFY(!mirror.applyPatch(patch.left(patch.size() - 4)));
+        QCOMPARE(mirror.serialize(), before);
+        QVERIFY(mirror.applyPatch(patch));
+        QCOMPARE(mirror.serialize(), source.serialize());
+    }
+
+    void structData_data(){ rows(); }
+    void structData(){
+        QFETCH(QString, type);
+        QFETCH(int, rows);
+        if(type != QLatin1String("Member"))
+            QSKIP("Only Member has a struct row.");
+        benchStructData(rows);
+    }
+
+    void roleNames_data(){ rows(); }
+    void roleNames(){ BENCH_DISPATCH(benchRoleNames) }
+
+    void clear_data(){ rows(); }
+    void clear(){ BENCH_DISPATCH(benchClear) }
+
+    void cloneData_data(){ rows(); }
+    void cloneData(){ BENCH_DISPATCH(benchCloneData) }
+
+    void toJson_data(){ rows(); }
+    void toJson(){ BENCH_DISPATCH(benchToJson) }
+
+    void fromJson_data(){ rows(); }
+    void fromJson(){ BENCH_DISPATCH(benchFromJson) }
+
+    void toBytes_data(){ rows(); }
+    void toBytes(){ BENCH_DISPATCH(benchToBytes) }
+
+    void fromBytes_data(){ rows(); }
+    void fromBytes(){ BENCH_DISPATCH(benchFromBytes) }
+
+    void fromBytesSchema_data(){ rows(); }
+    void fromBytesSchema(){ BENCH_DISPATCH(benchFromBytesSchema) }
+
+    /**
+      * Scaling of the parallel export and import over the thread count
+      */
+    void toBytesParallel_data(){ threads(); }
+    void toBytesParallel(){
+        QFETCH(int, threads);
+        MemberModel& model = largeModel();
+        QByteArray buffer;
+        QBENCHMARK_ONCE {
+            QDataStream s(&buffer, QIODevice::WriteOnly);
+            model.toBytesParallel(s, threads);
+        }
+    }
+
+    void toJsonCompactParallel_data(){ threads(); }
+    void toJsonCompactParallel(){
+        QFETCH(int, threads);
+        MemberModel& model = largeModel();
+        QBENCHMARK_ONCE {
+            model.toJsonCompactParallel(threads);
+        }
+    }
+
+    void fromBytesFramed_data(){ threads(); }
+    void fromBytesFramed(){
+        QFETCH(int, threads);
+        QByteArray buffer;
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        largeModel().toBytesFramed(out);
+        MemberModel model;
+        QBENCHMARK_ONCE {
+            QDataStream in(buffer);
+            model.fromBytesFramed(in, threads);
+        }
+    }
+
+    void cleanupTestCase(){
+        delete mLargeModel;
+        mLargeModel = Q_NULLPTR;
+    }
+
+private:
+    void rows(){
+        QTest::addColumn<QString>("type");
+        QTest::addColumn<int>("rows");
+        const int maxRows = qEnvironmentVariableIsSet("QMLLISTMODEL_BENCH_MAX_ROWS") ?
+                    qgetenv("QMLLISTMODEL_BENCH_MAX_ROWS").toInt() : 1000000;
+        for(const char* type : {"Member", "Apartment"}){
+            for(int count : {1000, 100000, 1000000}){
+                if(count > maxRows)
+                    continue;
+                const QByteArray& tag = QByteArray(type) + '/' + QByteArray::number(count);
+                QTest::newRow(tag.constData()) << QString::fromLatin1(type) << count;
+            }
+        }
+    }
+
+    void threads(){
+        QTest::addColumn<int>("threads");
+        for(int t : {1, 2, 4, 8, 16})
+            QTest::newRow(QByteArray::number(t).constData()) << t;
+    }
+
+    MemberModel& largeModel(){
+        if(mLargeModel == Q_NULLPTR){
+            const int maxRows = qEnvironmentVariableIsSet("QMLLISTMODEL_BENCH_MAX_ROWS") ?
+                        qgetenv("QMLLISTMODEL_BENCH_MAX_ROWS").toInt() : 1000000;
+            mLargeModel = new MemberModel;
+            fill<MemberModel, Member>(*mLargeModel, qMin(maxRows, 1000000));
+            mLargeModel->setSnapshotTracking(true);
+        }
+        return *mLargeModel;
+    }
+
+    MemberModel* mLargeModel = Q_NULLPTR;
+};
+
+/**
+ * @brief writeJson converts the QtTest xml log into a Json array of results
+ * @param xmlFile
+ * @param jsonFile
+ * @return
+ */
+static bool writeJson(const QString& xmlFile, const QString& jsonFile)
+{
+    QFile xml(xmlFile);
+    if(!xml.open(QIODevice::ReadOnly))
+        return false;
+    QJsonArray results;
+    QString function;
+    QXmlStreamReader reader(&xml);
+    while(!reader.atEnd()){
+        if(reader.readNext() != QXmlStreamReader::StartElement)
+            continue;
+        const QXmlStreamAttributes& a = reader.attributes();
+        if(reader.name() == QLatin1String("TestFunction")){
+            function = a.value(QLatin1String("name")).toString();
+        } else if(reader.name() == QLatin1String("BenchmarkResult")){
+            QJsonObject result;
+            result.insert("function", function);
+            result.insert("tag", a.value(QLatin1String("tag")).toString());
+            result.insert("metric", a.value(QLatin1String("metric")).toString());
+            result.insert("value", a.value(QLatin1String("value")).toDouble());
+            result.insert("iterations", a.value(QLatin1String("iterations")).toInt());
+            results.append(result);
+        }
+    }
+    QFile json(jsonFile);
+    if(reader.hasError() || !json.open(QIODevice::WriteOnly))
+        return false;
+    QJsonObject root;
+    root.insert("benchmark", "QmlListModelBench");
+    root.insert("revision", QString::fromLocal8Bit(qgetenv("QMLLISTMODEL_BENCH_REVISION")));
+    root.insert("results", results);
+    json.write(QJsonDocument(root).toJson());
+    return true;
+}
+
+/**
+  * Usage: QmlListModelBench [-json results.json] [QtTest options]
+  */
+int main(int argc, char *argv[])
+{
+    if(!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QString jsonFile, xmlFile;
+    const int json = args.indexOf(QStringLiteral("-json"));
+    if(json > 0 && json + 1 < args.size()){
+        jsonFile = args.at(json + 1);
+        args.removeAt(json + 1);
+        args.removeAt(json);
+        xmlFile = jsonFile + QStringLiteral(".xml");
+        args << QStringLiteral("-o") << xmlFile + QStringLiteral(",xml")
+             << QStringLiteral("-o") << QStringLiteral("-,txt");
+    }
+    BenchModel bench;
+    const int result = QTest::qExec(&bench, args);
+    if(!jsonFile.isEmpty()){
+        if(!writeJson(xmlFile, jsonFile))
+            qWarning()<<"QmlListModelBench"<<"Error: Writing"<<jsonFile<<"failed.";
+        QFile::remove(xmlFile);
+    }
+    return result;
+}
+
+#include "bench_model.moc"
@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+"""Compare two QmlListModelBench -json result files.
+
+Usage: compare.py baseline.json current.json [threshold]
+
+Prints the ratio current/baseline of every benchmark present in both files
+and exits with 1 when any of them is slower than the threshold (default 1.10).
+"""
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        root = json.load(f)
+    return {(r["function"], r["tag"], r["metric"]): r["value"] for r in root["results"]}
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        return 2
+    baseline, current = load(sys.argv[1]), load(sys.argv[2])
+    threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 1.10
+    regressed = False
+    for key in sorted(baseline.keys() & current.keys()):
+        before, after = baseline[key], current[key]
+        ratio = after / before if before else float("inf") if after else 1.0
+        mark = ""
+        if ratio > threshold:
+            mark = "  REGRESSION"
+            regressed = True
+        print("%-24s %-18s %-22s %12.3f %12.3f %6.2fx%s" % (key + (before, after, ratio, mark)))
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
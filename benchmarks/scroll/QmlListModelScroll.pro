@@ -0,0 +1,17 @@
+TEMPLATE = app
+
+TARGET = QmlListModelScroll
+
+QT += qml quick
+
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
+
+HEADERS += \
+    ../../QmlListModel.h
+
+QMAKE_CXXFLAGS += -std=c++11
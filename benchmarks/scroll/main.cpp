@@ -0,0 +1,265 @@
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQmlProperty>
+#include <QQuickWindow>
+#include <QQuickItem>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include "QmlListModel.h"
+
+/**
+  * Global operator new counter. It counts the C++ allocations of the process only,
+  * the Qt containers and strings allocate by malloc() and are not counted.
+  */
+static std::atomic<quint64> gOperatorNewCalls(0);
+
+void* operator new(std::size_t size)
+{
+    ++gOperatorNewCalls;
+    if(void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+/**
+ * @brief The BenchRow class has 16 roles, the delegate binds the first --roles of them
+ */
+class BenchRow : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString role0 MEMBER mS0)
+    Q_PROPERTY(int role1 MEMBER mI1)
+    Q_PROPERTY(QString role2 MEMBER mS2)
+    Q_PROPERTY(int role3 MEMBER mI3)
+    Q_PROPERTY(QString role4 MEMBER mS4)
+    Q_PROPERTY(int role5 MEMBER mI5)
+    Q_PROPERTY(QString role6 MEMBER mS6)
+    Q_PROPERTY(int role7 MEMBER mI7)
+    Q_PROPERTY(QString role8 MEMBER mS8)
+    Q_PROPERTY(int role9 MEMBER mI9)
+    Q_PROPERTY(QString role10 MEMBER mS10)
+    Q_PROPERTY(int role11 MEMBER mI11)
+    Q_PROPERTY(QString role12 MEMBER mS12)
+    Q_PROPERTY(int role13 MEMBER mI13)
+    Q_PROPERTY(QString role14 MEMBER mS14)
+    Q_PROPERTY(int role15 MEMBER mI15)
+public:
+    explicit BenchRow(int i = 0):
+        mS0(QString::number(i)), mI1(i), mS2(mS0), mI3(i), mS4(mS0), mI5(i), mS6(mS0), mI7(i),
+        mS8(mS0), mI9(i), mS10(mS0), mI11(i), mS12(mS0), mI13(i), mS14(mS0), mI15(i){}
+
+    QString mS0; int mI1; QString mS2; int mI3; QString mS4; int mI5; QString mS6; int mI7;
+    QString mS8; int mI9; QString mS10; int mI11; QString mS12; int mI13; QString mS14; int mI15;
+};
+
+/**
+ * @brief The BenchModel class counts the data() calls per role
+ */
+class BenchModel : public QmlListModel<BenchRow>
+{
+    Q_OBJECT
+    QML_LIST_MODEL
+public:
+    explicit BenchModel(){}
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        ++mDataCalls[role];
+        return QmlListModel<BenchRow>::data(index, role);
+    }
+
+    mutable QHash<int, quint64> mDataCalls;
+};
+
+/**
+ * @brief The DelegateProbe class counts the delegate instantiations
+ */
+class DelegateProbe : public QQuickItem
+{
+    Q_OBJECT
+public:
+    explicit DelegateProbe(QQuickItem* parent = 0):
+        QQuickItem(parent){
+        ++sCreated;
+    }
+
+    static quint64 sCreated;
+};
+
+quint64 DelegateProbe::sCreated = 0;
+
+static QByteArray scene(int roles)
+{
+    QByteArray texts;
+    for(int r = 0; r < roles; ++r){
+        texts += "                Text { text: role" + QByteArray::number(r) + " }\n";
+    }
+    return "import QtQuick 2.2\n"
+           "import QtQuick.Window 2.1\n"
+           "import QmlListModelBench 1.0\n"
+           "Window {\n"
+           "    width: 480; height: 800; visible: true\n"
+           "    ListView {\n"
+           "        objectName: \"view\"\n"
+           "        anchors.fill: parent\n"
+           "        model: benchModel\n"
+           "        delegate: Item {\n"
+           "            width: 480; height: 24\n"
+           "            DelegateProbe {}\n"
+           "            Row {\n"
+           "                spacing: 4\n"
+           + texts +
+           "            }\n"
+           "        }\n"
+           "    }\n"
+           "}\n";
+}
+
+static double percentile(QVector<double> values, double p)
+{
+    if(values.isEmpty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    return values.at(qMin(values.size() - 1, int(p * values.size())));
+}
+
+/**
+  * Usage: QmlListModelScroll [--rows N] [--roles R] [--frames F] [--step PX] [--viewport] [--json file]
+  * Scrolls a ListView over a QmlListModel offscreen with the software backend,
+  * one synchronous frame per step.
+  */
+int main(int argc, char *argv[])
+{
+    if(!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    if(!qEnvironmentVariableIsSet("QT_QUICK_BACKEND"))
+        qputenv("QT_QUICK_BACKEND", "software");
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("rows", "Model rows.", "N", "100000"));
+    parser.addOption(QCommandLineOption("roles", "Roles bound by the delegate, 1 to 16.", "R", "4"));
+    parser.addOption(QCommandLineOption("frames", "Frames to scroll.", "F", "600"));
+    parser.addOption(QCommandLineOption("step", "Pixels scrolled per frame.", "PX", "40"));
+    parser.addOption(QCommandLineOption("viewport", "Tell the model the visible rows and bound roles every frame."));
+    parser.addOption(QCommandLineOption("json", "Json result file.", "file"));
+    parser.process(app);
+    const int rows = parser.value("rows").toInt(),
+              roles = qBound(1, parser.value("roles").toInt(), 16),
+              frames = parser.value("frames").toInt();
+    const double step = parser.value("step").toDouble();
+    const bool viewport = parser.isSet("viewport");
+    QStringList boundRoles;
+    for(int r = 0; r < roles; ++r)
+        boundRoles.append(QStringLiteral("role%1").arg(r));
+
+    BenchModel model;
+    QList<BenchRow*> data;
+    data.reserve(rows);
+    for(int i = 0; i < rows; ++i)
+        data.append(new BenchRow(i));
+    model.appendData(data);
+
+    qmlRegisterType<DelegateProbe>("QmlListModelBench", 1, 0, "DelegateProbe");
+    QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("benchModel", &model);
+    engine.loadData(scene(roles));
+    QQuickWindow* window = engine.rootObjects().isEmpty() ? Q_NULLPTR : qobject_cast<QQuickWindow*>(engine.rootObjects().first());
+    QQuickItem* view = window == Q_NULLPTR ? Q_NULLPTR : window->contentItem()->findChild<QQuickItem*>("view");
+    if(view == Q_NULLPTR){
+        qWarning()<<"QmlListModelScroll"<<"Error: Loading the scene failed.";
+        return 1;
+    }
+    window->grabWindow();
+
+    /**
+      * Measure the steady state, not the first layout
+      */
+    model.mDataCalls.clear();
+    DelegateProbe::sCreated = 0;
+    const quint64 operatorNewCalls = gOperatorNewCalls.load();
+    QVector<double> frameTimes;
+    QJsonArray frameLog;
+    QElapsedTimer timer;
+    const double maxY = qMax(0.0, 24.0 * rows - window->height());
+    double y = 0;
+    for(int f = 0; f < frames; ++f){
+        const quint64 frameOperatorNewCalls = gOperatorNewCalls.load();
+        y = y + step > maxY ? 0 : y + step;
+        timer.start();
+        if(viewport)
+            model.setViewport(int(y / 24), int((y + window->height()) / 24), boundRoles);
+        QQmlProperty::write(view, "contentY", y);
+        window->grabWindow();
+        const double ms = timer.nsecsElapsed() / 1e6;
+        frameTimes.append(ms);
+        QJsonObject frame;
+        frame.insert("ms", ms);
+        frame.insert("operatorNewCalls", double(gOperatorNewCalls.load() - frameOperatorNewCalls));
+        frameLog.append(frame);
+    }
+
+    quint64 dataCalls = 0;
+    QJsonObject perRole;
+    const QHash<int, QByteArray>& names = static_cast<QAbstractItemModel&>(model).roleNames();
+    for(auto it = model.mDataCalls.constBegin(); it != model.mDataCalls.constEnd(); ++it){
+        dataCalls += it.value();
+        perRole.insert(QString::fromLatin1(names.value(it.key(), QByteArray::number(it.key()))), double(it.value()));
+    }
+    double total = 0;
+    for(double ms : frameTimes)
+        total += ms;
+
+    QJsonObject result;
+    result.insert("rows", rows);
+    result.insert("roles", roles);
+    result.insert("frames", frames);
+    result.insert("frameMsMean", frames > 0 ? total / frames : 0);
+    result.insert("frameMsP50", percentile(frameTimes, 0.5));
+    result.insert("frameMsP95", percentile(frameTimes, 0.95));
+    result.insert("frameMsMax", percentile(frameTimes, 1.0));
+    result.insert("dataCalls", double(dataCalls));
+    result.insert("dataCallsPerRole", perRole);
+    result.insert("delegatesCreated", double(DelegateProbe::sCreated));
+    result.insert("viewportHitRatio", model.viewportHitRatio());
+    result.insert("operatorNewCalls", double(gOperatorNewCalls.load() - operatorNewCalls));
+    result.insert("frameLog", frameLog);
+
+    QJsonObject summary = result;
+    summary.remove("frameLog");
+    qInfo().noquote()<<QJsonDocument(summary).toJson();
+    if(parser.isSet("json")){
+        QFile json(parser.value("json"));
+        if(!json.open(QIODevice::WriteOnly)){
+            qWarning()<<"QmlListModelScroll"<<"Error: Writing"<<json.fileName()<<"failed.";
+            return 1;
+        }
+        json.write(QJsonDocument(result).toJson());
+    }
+    return 0;
+}
+
+#include "main.moc"
@@ -0,0 +1,26 @@
+TEMPLATE = app
+
+TARGET = QmlListModelTests
+
+QT += qml testlib sql
+QT -= gui
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+DEFINES += UsingSerialize=1 UsingJson=1
+
+INCLUDEPATH += ../QmlListModelDemo ..
+
+SOURCES += tst_qmllistmodel.cpp
+
+HEADERS += \
+    ../QmlListModelDemo/QmlListModel.h \
+    ../QmlListGroupModel.h \
+    ../QmlListJoinModel.h \
+    ../QmlListSearchIndex.h \
+    ../QmlListSharedModel.h \
+    ../QmlListSqlStore.h \
+    ../QmlStructListModel.h
+
+QMAKE_CXXFLAGS += -std=c++11
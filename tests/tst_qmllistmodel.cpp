@@ -0,0 +1,813 @@
+#include <QtTest>
+#include <limits>
+#include "QmlListModel.h"
+#include "QmlListGroupModel.h"
+#include "QmlListJoinModel.h"
+#include "QmlListSearchIndex.h"
+#include "QmlListSharedModel.h"
+#include "QmlListSqlStore.h"
+#include "QmlStructListModel.h"
+
+/**
+  * A row of the tests: a name, a category and a number
+  */
+class Item : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString name MEMBER mName)
+    Q_PROPERTY(QString category MEMBER mCategory)
+    Q_PROPERTY(int number MEMBER mNumber)
+public:
+    explicit Item(): mNumber(0){}
+    explicit Item(const QString& aName, const QString& aCategory = QString(), int aNumber = 0):
+        mName(aName), mCategory(aCategory), mNumber(aNumber){}
+
+    QString mName;
+    QString mCategory;
+    int     mNumber;
+};
+
+QML_LIST_ROLE(ItemNameRole, Item, mName, name);
+QML_LIST_ROLE(ItemCategoryRole, Item, mCategory, category);
+QML_LIST_ROLE(ItemNumberRole, Item, mNumber, number);
+
+class ItemModel : public QmlListModel<Item>
+{
+    Q_OBJECT
+    QML_LIST_MODEL
+public:
+    explicit ItemModel(){}
+};
+
+/**
+  * A plain struct row of the struct model tests
+  */
+#define POINT_FIELDS(F) F(int, x) F(int, y) F(QString, label)
+struct Point { POINT_FIELDS(QML_STRUCT_MEMBER) };
+QML_STRUCT(Point, POINT_FIELDS)
+
+class PointModel : public QmlStructListModel<Point>
+{
+    Q_OBJECT
+    QML_STRUCT_LIST_MODEL
+};
+
+static QStringList labels(const PointModel& model)
+{
+    QStringList list;
+    for(const Point& p : model.rows())
+        list.append(p.label);
+    return list;
+}
+
+static QList<Item*> newItems(const QStringList& names, const QString& category = QString())
+{
+    QList<Item*> items;
+    for(const QString& name : names)
+        items.append(new Item(name, category));
+    return items;
+}
+
+static QVector<int> numbers(const ItemModel& model)
+{
+    QVector<int> list;
+    for(int i = 0; i < model.rowCount(QModelIndex()); ++i)
+        list.append(model.value<ItemNumberRole>(i));
+    return list;
+}
+
+static QStringList names(const ItemModel& model)
+{
+    QStringList list;
+    for(int i = 0; i < model.rowCount(QModelIndex()); ++i)
+        list.append(model.value<ItemNameRole>(i));
+    return list;
+}
+
+/**
+  * The rows of a group model, "[key]" for a header and the name for a member
+  */
+static QStringList groupedNames(const QmlListGroupModel& groups)
+{
+    QStringList rows;
+    for(int i = 0; i < groups.rowCount(); ++i){
+        const QModelIndex& index = groups.index(i);
+        if(groups.data(index, QmlListGroupModel::GroupHeaderRole).toBool())
+            rows.append(QLatin1Char('[') + groups.data(index, QmlListGroupModel::GroupKeyRole).toString() + QLatin1Char(']'));
+        else
+            rows.append(groups.data(index, ItemNameRole::role()).toString());
+    }
+    return rows;
+}
+
+/**
+  * The first and last row of the next signal of a rowsInserted or rowsRemoved spy
+  */
+static QVariantList takeRange(QSignalSpy& spy)
+{
+    return spy.isEmpty() ? QVariantList() : spy.takeFirst().mid(1);
+}
+
+/**
+  * The first row, last row and roles of the next signal of a dataChanged spy
+  */
+static QString takeChanged(QSignalSpy& spy)
+{
+    if(spy.isEmpty())
+        return QString();
+    const QVariantList& args = spy.takeFirst();
+    QStringList roles;
+    for(int role : args.at(2).value<QVector<int> >())
+        roles.append(QString::number(role));
+    return QString("%1 %2 [%3]").arg(args.at(0).value<QModelIndex>().row())
+            .arg(args.at(1).value<QModelIndex>().row()).arg(roles.join(','));
+}
+
+/**
+  * A shared memory key of this test process
+  */
+static QString sharedKey(const char* name)
+{
+    return QStringLiteral("QmlListModelTest_%1_%2").arg(QCoreApplication::applicationPid()).arg(QLatin1String(name));
+}
+
+/**
+  * Creates a segment holding a header of one Int field, as a writer of the layout would
+  */
+static bool createSegment(QSharedMemory& memory, int size, quint32 capacity, quint32 fieldOffset)
+{
+    if(!memory.create(size))
+        return false;
+    std::memset(memory.data(), 0, size_t(memory.size()));
+    QmlListSharedLayout::Header* h = QmlListSharedLayout::header(memory.data());
+    h->magic = QmlListSharedLayout::Magic;
+    h->version = QmlListSharedLayout::Version;
+    h->fieldCount = 1;
+    h->rowSize = 8;
+    h->capacity = capacity;
+    h->ringCapacity = 1;
+    h->stringLength = 0;
+    QmlListSharedLayout::Field* f = QmlListSharedLayout::fields(memory.data());
+    qstrncpy(f->name, "number", sizeof(f->name));
+    f->type = QMetaType::Int;
+    f->offset = fieldOffset;
+    return true;
+}
+
+static QStringList names(const QmlListModelSnapshot& snapshot)
+{
+    QStringList list;
+    for(int i = 0; i < snapshot.size(); ++i)
+        list.append(snapshot.value(i, QByteArrayLiteral("name")).toString());
+    return list;
+}
+
+/**
+ * @brief The QmlListModelTest class checks the row contents and the model signals
+ * of the features built on QmlListModel
+ */
+class QmlListModelTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup(){
+        /**
+          * The removed rows are deleted later, release them between the tests
+          */
+        QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+    }
+
+    void snapshotOnce(){
+        ItemModel model;
+        model.appendData(newItems(QStringList() << "a" << "b"));
+        const QmlListModelSnapshot snapshot = model.snapshot();
+        QVERIFY(!model.isSnapshotTracking());
+        model.setValue<ItemNameRole>(0, QStringLiteral("a2"));
+        QCOMPARE(names(snapshot), QStringList() << "a" << "b");
+        QCOMPARE(names(model.snapshot()), QStringList() << "a2" << "b");
+    }
+
+    void snapshotAfterMutations(){
+        ItemModel model;
+        model.appendData(newItems(QStringList() << "a" << "b" << "c"));
+        model.setSnapshotTracking(true);
+        QVERIFY(model.isSnapshotTracking());
+        const QmlListModelSnapshot before = model.snapshot();
+        model.setValue<ItemNameRole>(1, QStringLiteral("b2"));
+        model.insertData(0, new Item(QStringLiteral("z")));
+        QVERIFY(model.moveData(0, 3));
+        QVERIFY(model.removeData(1));
+        const QmlListModelSnapshot after = model.snapshot();
+        QCOMPARE(names(before), QStringList() << "a" << "b" << "c");
+        QCOMPARE(names(after), QStringList() << "a" << "c" << "z");
+        QCOMPARE(names(after), names(model));
+
+        model.setSnapshotTracking(false);
+        QVERIFY(!model.isSnapshotTracking());
+        model.setValue<ItemNameRole>(0, QStringLiteral("a2"));
+        QCOMPARE(names(model.snapshot()), QStringList() << "a2" << "c" << "z");
+        QCOMPARE(names(after), QStringList() << "a" << "c" << "z");
+    }
+
+    void groupByRole(){
+        ItemModel model;
+        model.appendData(QList<Item*>() << new Item("a", "x") << new Item("b", "y") << new Item("c", "x"));
+        QmlListGroupModel groups;
+        groups.setSourceModel(&model);
+        groups.setGroupRole(QStringLiteral("category"));
+        QCOMPARE(groups.groupKeys(), QStringList() << "x" << "y");
+        QCOMPARE(groupedNames(groups), QStringList() << "[x]" << "a" << "c" << "[y]" << "b");
+        QCOMPARE(groups.groupSize(QStringLiteral("x")), 2);
+        QCOMPARE(groups.sourceRow(2), 2);
+        QCOMPARE(groups.sourceRow(0), -1);
+    }
+
+    void groupSignals(){
+        ItemModel model;
+        model.appendData(QList<Item*>() << new Item("a", "x") << new Item("b", "y") << new Item("c", "x"));
+        QmlListGroupModel groups;
+        groups.setSourceModel(&model);
+        groups.setGroupRole(QStringLiteral("category"));
+        QSignalSpy inserted(&groups, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy removed(&groups, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+        QSignalSpy changed(&groups, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+        QSignalSpy counted(&groups, SIGNAL(groupCountChanged()));
+
+        /**
+          * A member of an existing group, its header count changes
+          */
+        model.insertData(1, new Item("d", "x"));
+        QCOMPARE(inserted.count(), 1);
+        QCOMPARE(takeRange(inserted), QVariantList() << 2 << 2);
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(changed.takeFirst().at(0).value<QModelIndex>().row(), 0);
+        QCOMPARE(groupedNames(groups), QStringList() << "[x]" << "a" << "d" << "c" << "[y]" << "b");
+
+        /**
+          * A new group, inserted with its header in key order
+          */
+        model.appendData(new Item("e", "w"));
+        QCOMPARE(takeRange(inserted), QVariantList() << 0 << 1);
+        QCOMPARE(counted.count(), 1);
+        QCOMPARE(groupedNames(groups), QStringList() << "[w]" << "e" << "[x]" << "a" << "d" << "c" << "[y]" << "b");
+
+        /**
+          * The source is a d b c e, removing c shifts b and e lazily
+          */
+        QVERIFY(model.removeData(3));
+        QCOMPARE(removed.count(), 1);
+        QCOMPARE(takeRange(removed), QVariantList() << 5 << 5);
+        QCOMPARE(groupedNames(groups), QStringList() << "[w]" << "e" << "[x]" << "a" << "d" << "[y]" << "b");
+        QCOMPARE(groups.sourceRow(6), 2);
+        QCOMPARE(groups.sourceRow(1), 3);
+
+        /**
+          * A key change moves the row to its new group
+          */
+        changed.clear();
+        model.setValue<ItemCategoryRole>(0, QStringLiteral("y"));
+        QCOMPARE(takeRange(removed), QVariantList() << 3 << 3);
+        QCOMPARE(takeRange(inserted), QVariantList() << 5 << 5);
+        QCOMPARE(groupedNames(groups), QStringList() << "[w]" << "e" << "[x]" << "d" << "[y]" << "a" << "b");
+        QCOMPARE(groups.groupRows(QStringLiteral("y")), QVariantList() << 0 << 2);
+
+        /**
+          * The last member removes its group with the header
+          */
+        counted.clear();
+        QVERIFY(model.removeData(1));
+        QCOMPARE(takeRange(removed), QVariantList() << 2 << 3);
+        QCOMPARE(counted.count(), 1);
+        QCOMPARE(groups.groupKeys(), QStringList() << "w" << "y");
+        QCOMPARE(groupedNames(groups), QStringList() << "[w]" << "e" << "[y]" << "a" << "b");
+
+        /**
+          * Collapsing hides the members, the header stays
+          */
+        groups.setCollapsed(QStringLiteral("y"), true);
+        QCOMPARE(takeRange(removed), QVariantList() << 3 << 4);
+        QCOMPARE(groupedNames(groups), QStringList() << "[w]" << "e" << "[y]");
+        groups.setCollapsed(QStringLiteral("y"), false);
+        QCOMPARE(takeRange(inserted), QVariantList() << 3 << 4);
+        QCOMPARE(groupedNames(groups), QStringList() << "[w]" << "e" << "[y]" << "a" << "b");
+        QVERIFY(inserted.isEmpty());
+        QVERIFY(removed.isEmpty());
+    }
+
+    void searchIndex(){
+        ItemModel model;
+        model.appendData(newItems(QStringList() << "Alpha Beta" << "Gamma" << "alphabet soup"));
+        QmlListSearchIndex index(&model, QStringList() << "name");
+        QVERIFY(index.rows(QStringLiteral("alp")).isEmpty());
+        index.build();
+        QVERIFY(index.isReady());
+        QCOMPARE(index.rows(QStringLiteral("ALP")), QVector<int>() << 0 << 2);
+        QCOMPARE(index.rows(QStringLiteral("bet")), QVector<int>() << 0 << 2);
+        QCOMPARE(index.rows(QStringLiteral("bet"), QmlListSearchIndex::Prefix), QVector<int>() << 0);
+        QCOMPARE(index.rows(QStringLiteral("ga")), QVector<int>() << 1);
+        QCOMPARE(index.rows(QString()), QVector<int>() << 0 << 1 << 2);
+        QVERIFY(index.rows(QStringLiteral("delta")).isEmpty());
+        QCOMPARE(index.search(QStringLiteral("soup")), QVariantList() << 2);
+
+        /**
+          * The index follows the model and renumbers its rows on the next query
+          */
+        model.insertData(0, new Item(QStringLiteral("Beta Max")));
+        QCOMPARE(index.rows(QStringLiteral("bet")), QVector<int>() << 0 << 1 << 3);
+        QVERIFY(model.removeData(1));
+        QCOMPARE(index.rows(QStringLiteral("bet")), QVector<int>() << 0 << 2);
+        model.setValue<ItemNameRole>(1, QStringLiteral("Betamax"));
+        QCOMPARE(index.rows(QStringLiteral("bet")), QVector<int>() << 0 << 1 << 2);
+        model.setValue<ItemNameRole>(0, QStringLiteral("Gamma"));
+        QCOMPARE(index.rows(QStringLiteral("bet")), QVector<int>() << 1 << 2);
+        QVERIFY(model.moveData(2, 0));
+        QCOMPARE(names(model), QStringList() << "alphabet soup" << "Gamma" << "Betamax");
+        QCOMPARE(index.rows(QStringLiteral("bet")), QVector<int>() << 0 << 2);
+        QCOMPARE(index.rows(QStringLiteral("gam")), QVector<int>() << 1);
+    }
+
+    void searchIndexAsync(){
+        ItemModel model;
+        model.appendData(newItems(QStringList() << "Alpha Beta" << "Gamma" << "alphabet soup"));
+        QmlListSearchIndex index(&model, QStringList() << "name");
+        QSignalSpy ready(&index, SIGNAL(readyChanged()));
+        index.buildAsync();
+        /**
+          * A change made while building is applied when it finishes
+          */
+        model.setValue<ItemNameRole>(1, QStringLiteral("Betatron"));
+        QTRY_VERIFY(index.isReady());
+        QCOMPARE(ready.count(), 1);
+        QCOMPARE(index.rows(QStringLiteral("bet")), QVector<int>() << 0 << 1 << 2);
+        QVERIFY(index.rows(QStringLiteral("gamma")).isEmpty());
+    }
+
+    void patchRoundTrip(){
+        ItemModel source, mirror;
+        source.appendData(newItems(QStringList() << "a" << "b" << "c"));
+        mirror.unserialize(source.serialize());
+        mirror.setPatchRevision(source.patchRevision());
+        source.setPatchRecording(true);
+        source.insertData(1, new Item(QStringLiteral("d")));
+        source.setValue<ItemNumberRole>(2, 7);
+        QVERIFY(source.moveData(0, 3));
+        QVERIFY(source.removeData(0));
+        const QByteArray& patch = source.takePatch();
+        QVERIFY(!patch.isEmpty());
+        QCOMPARE(source.patchRevision(), quint32(1));
+
+        QSignalSpy inserted(&mirror, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy removed(&mirror, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+        QSignalSpy moved(&mirror, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+        QSignalSpy changed(&mirror, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+        QVERIFY(mirror.applyPatch(patch));
+        QCOMPARE(names(mirror), names(source));
+        QCOMPARE(names(mirror), QStringList() << "b" << "c" << "a");
+        QCOMPARE(mirror.value<ItemNumberRole>(0), 7);
+        QCOMPARE(mirror.patchRevision(), quint32(1));
+        QCOMPARE(inserted.count(), 1);
+        QCOMPARE(removed.count(), 1);
+        QCOMPARE(moved.count(), 1);
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(changed.takeFirst().at(2).value<QVector<int> >(), QVector<int>() << ItemNumberRole::role());
+    }
+
+    void patchRejected(){
+        ItemModel source, mirror;
+        source.appendData(newItems(QStringList() << "a" << "b"));
+        mirror.appendData(newItems(QStringList() << "a" << "b"));
+        source.setPatchRecording(true);
+        source.appendData(new Item(QStringLiteral("c")));
+        const QByteArray& first = source.takePatch();
+        QVERIFY(source.removeData(0));
+        const QByteArray& second = source.takePatch();
+        QSignalSpy reset(&mirror, SIGNAL(modelReset()));
+        QSignalSpy inserted(&mirror, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy removed(&mirror, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+        /**
+          * Not a patch
+          */
+        QVERIFY(!mirror.applyPatch(QByteArray("not a patch")));
+        QVERIFY(!mirror.applyPatch(QByteArray()));
+
+        /**
+          * A patch for another revision
+          */
+        QVERIFY(!mirror.applyPatch(second));
+
+        /**
+          * A patch cut short, its operation count is not reached
+          */
+        QVERIFY(!mirror.applyPatch(first.left(first.size() - 1)));
+
+        /**
+          * Operations out of the rows they apply to
+          */
+        QByteArray outOfRange;
+        {
+            QDataStream s(&outOfRange, QIODevice::WriteOnly);
+            s << QAbstractBase::PatchMagic << quint32(0) << quint32(1) << quint32(2)
+              << quint8(QAbstractBase::PatchRemove) << quint32(0) << quint32(1)
+              << quint8(QAbstractBase::PatchRemove) << quint32(1) << quint32(1);
+        }
+        QVERIFY(!mirror.applyPatch(outOfRange));
+        QByteArray wrongRole;
+        {
+            QDataStream s(&wrongRole, QIODevice::WriteOnly);
+            s << QAbstractBase::PatchMagic << quint32(0) << quint32(1) << quint32(1)
+              << quint8(QAbstractBase::PatchChange) << quint32(0) << quint32(1) << quint16(1) << quint16(0);
+        }
+        QVERIFY(!mirror.applyPatch(wrongRole));
+        QByteArray wrongOperation;
+        {
+            QDataStream s(&wrongOperation, QIODevice::WriteOnly);
+            s << QAbstractBase::PatchMagic << quint32(0) << quint32(1) << quint32(1)
+              << quint8(9) << quint32(0) << quint32(1);
+        }
+        QVERIFY(!mirror.applyPatch(wrongOperation));
+
+        /**
+          * Nothing was applied, the patches in order still are
+          */
+        QCOMPARE(names(mirror), QStringList() << "a" << "b");
+        QCOMPARE(mirror.patchRevision(), quint32(0));
+        QVERIFY(reset.isEmpty());
+        QVERIFY(inserted.isEmpty());
+        QVERIFY(removed.isEmpty());
+        QVERIFY(mirror.applyPatch(first));
+        QVERIFY(mirror.applyPatch(second));
+        QCOMPARE(names(mirror), QStringList() << "b" << "c");
+        QCOMPARE(mirror.patchRevision(), quint32(2));
+    }
+
+    void sharedModel(){
+        ItemModel source;
+        source.appendData(QList<Item*>() << new Item("a", "x", 1) << new Item("b", "y", 2));
+        QmlListSharedPublisher publisher(&source, sharedKey("rows"), 16);
+        if(!publisher.isAttached())
+            QSKIP("No shared memory");
+        QmlListSharedModel reader;
+        reader.setKey(sharedKey("rows"));
+        reader.setPollInterval(0);
+        QVERIFY(reader.isAttached());
+        const int name = reader.roleNames().key(QByteArrayLiteral("name"), -1),
+                  number = reader.roleNames().key(QByteArrayLiteral("number"), -1);
+        QVERIFY(name >= Qt::UserRole);
+        QVERIFY(number >= Qt::UserRole);
+        QCOMPARE(reader.rowCount(), 2);
+        QCOMPARE(reader.data(reader.index(1), name).toString(), QStringLiteral("b"));
+        QCOMPARE(reader.data(reader.index(1), number).toInt(), 2);
+
+        QSignalSpy inserted(&reader, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy removed(&reader, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+        QSignalSpy moved(&reader, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+        QSignalSpy changed(&reader, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+        QSignalSpy reset(&reader, SIGNAL(modelReset()));
+        source.insertData(1, new Item("c", "x", 3));
+        source.setValue<ItemNumberRole>(0, 5);
+        QVERIFY(source.moveData(2, 0));
+        QVERIFY(source.removeData(2));
+        QVERIFY(inserted.isEmpty());
+
+        /**
+          * The ring replays as one signal per operation
+          */
+        reader.poll();
+        QCOMPARE(takeRange(inserted), QVariantList() << 1 << 1);
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(changed.takeFirst().at(0).value<QModelIndex>().row(), 0);
+        QCOMPARE(moved.count(), 1);
+        QCOMPARE(moved.first().at(1).toInt(), 2);
+        QCOMPARE(moved.first().at(4).toInt(), 0);
+        QCOMPARE(takeRange(removed), QVariantList() << 2 << 2);
+        QVERIFY(reset.isEmpty());
+        QCOMPARE(reader.rowCount(), 2);
+        QCOMPARE(reader.data(reader.index(0), name).toString(), QStringLiteral("b"));
+        QCOMPARE(reader.data(reader.index(1), name).toString(), QStringLiteral("a"));
+        QCOMPARE(reader.data(reader.index(1), number).toInt(), 5);
+        QVERIFY(!reader.data(reader.index(2), name).isValid());
+    }
+
+    void sharedModelMalformed(){
+        QmlListSharedModel reader;
+        reader.setPollInterval(0);
+
+        /**
+          * Smaller than a header
+          */
+        QSharedMemory tiny(sharedKey("tiny"));
+        if(!tiny.create(8))
+            QSKIP("No shared memory");
+        std::memset(tiny.data(), 0xFF, 8);
+        reader.setKey(sharedKey("tiny"));
+        QVERIFY(!reader.isAttached());
+
+        /**
+          * A header claiming more rows than the segment holds
+          */
+        QSharedMemory truncated(sharedKey("truncated"));
+        QVERIFY(createSegment(truncated, 4096, 1000000, 0));
+        reader.setKey(sharedKey("truncated"));
+        QVERIFY(!reader.isAttached());
+
+        /**
+          * A field out of its record
+          */
+        QSharedMemory field(sharedKey("field"));
+        QVERIFY(createSegment(field, 4096, 1, 8));
+        reader.setKey(sharedKey("field"));
+        QVERIFY(!reader.isAttached());
+
+        /**
+          * The same layout with the field in its record attaches
+          */
+        QSharedMemory valid(sharedKey("valid"));
+        QVERIFY(createSegment(valid, 4096, 1, 4));
+        reader.setKey(sharedKey("valid"));
+        QVERIFY(reader.isAttached());
+        QCOMPARE(reader.rowCount(), 0);
+        QCOMPARE(reader.roleNames().value(Qt::UserRole), QByteArrayLiteral("number"));
+    }
+
+    void sqlStore(){
+        if(!QSqlDatabase::isDriverAvailable(QStringLiteral("QSQLITE")))
+            QSKIP("No QSQLITE driver");
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString& fileName = dir.filePath(QStringLiteral("items.db"));
+        {
+            ItemModel model;
+            QmlListSqlStore store(&model, fileName, QStringLiteral("items"));
+            QVERIFY(store.open());
+            model.appendData(QList<Item*>() << new Item("a", "x", 1) << new Item("b", "y", 2) << new Item("c", "x", 3));
+            store.flush(true);
+        }
+        {
+            /**
+              * The rows come back a page at a time, in order
+              */
+            ItemModel model;
+            QmlListSqlStore store(&model, fileName, QStringLiteral("items"));
+            QVERIFY(store.open(2));
+            QCOMPARE(model.rowCount(QModelIndex()), 0);
+            QVERIFY(model.canFetchMore(QModelIndex()));
+            QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+            model.fetchMore(QModelIndex());
+            QCOMPARE(takeRange(inserted), QVariantList() << 0 << 1);
+            QVERIFY(model.canFetchMore(QModelIndex()));
+            model.fetchMore(QModelIndex());
+            QCOMPARE(takeRange(inserted), QVariantList() << 2 << 2);
+            QVERIFY(!model.canFetchMore(QModelIndex()));
+            QCOMPARE(names(model), QStringList() << "a" << "b" << "c");
+            QCOMPARE(numbers(model), QVector<int>() << 1 << 2 << 3);
+            QCOMPARE(model.value<ItemCategoryRole>(1), QStringLiteral("y"));
+
+            model.setValue<ItemNumberRole>(1, 20);
+            QVERIFY(model.moveData(2, 0));
+            QVERIFY(model.removeData(1));
+            model.insertData(1, new Item("d", "z", 4));
+            QCOMPARE(names(model), QStringList() << "c" << "d" << "b");
+        }
+        {
+            /**
+              * The changes were written behind, with the order of the moved and inserted rows
+              */
+            ItemModel model;
+            QmlListSqlStore store(&model, fileName, QStringLiteral("items"));
+            QVERIFY(store.open());
+            while(model.canFetchMore(QModelIndex()))
+                model.fetchMore(QModelIndex());
+            QCOMPARE(names(model), QStringList() << "c" << "d" << "b");
+            QCOMPARE(numbers(model), QVector<int>() << 3 << 4 << 20);
+        }
+    }
+
+    void structModel(){
+        PointModel model;
+        QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy changed(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+        const Point a = {1, 2, QStringLiteral("a")}, b = {3, 4, QStringLiteral("b")};
+        model.appendData(QVector<Point>() << a << b);
+        QCOMPARE(takeRange(inserted), QVariantList() << 0 << 1);
+        QCOMPARE(model.roleNames().value(Qt::UserRole + 2), QByteArrayLiteral("label"));
+        QCOMPARE(model.data(model.index(1), Qt::UserRole).toInt(), 3);
+        QVERIFY(!model.data(model.index(1), Qt::UserRole + 3).isValid());
+
+        /**
+          * A typed write notifies its role only, an equal value nothing
+          */
+        QVERIFY(model.setValue<PointModel::Field::y>(0, 5));
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(changed.takeFirst().at(2).value<QVector<int> >(), QVector<int>() << Qt::UserRole + 1);
+        QVERIFY(model.setValue<PointModel::Field::y>(0, 5));
+        QVERIFY(changed.isEmpty());
+        QCOMPARE(model.value<PointModel::Field::y>(0), 5);
+        QVERIFY(model.setData(model.index(1), QStringLiteral("b2"), Qt::UserRole + 2));
+        QCOMPARE(model.value<PointModel::Field::label>(1), QStringLiteral("b2"));
+        QCOMPARE(changed.count(), 1);
+
+        /**
+          * getRange clamps a count running past the rows
+          */
+        const QVariantList& range = model.getRange(1, std::numeric_limits<int>::max(), QStringList() << "x");
+        QCOMPARE(range.size(), 1);
+        QCOMPARE(range.first().toMap().size(), 1);
+        QCOMPARE(range.first().toMap().value(QStringLiteral("x")).toInt(), 3);
+        QVERIFY(model.getRange(2, 1, QStringList()).isEmpty());
+
+        QVERIFY(model.moveData(1, 0));
+        QCOMPARE(labels(model), QStringList() << "b2" << "a");
+        QVERIFY(model.removeData(0));
+        QCOMPARE(labels(model), QStringList() << "a");
+    }
+
+    void structModelBytes(){
+        PointModel source;
+        const Point a = {1, 2, QStringLiteral("a")}, b = {3, 4, QStringLiteral("b")}, c = {5, 6, QStringLiteral("c")};
+        source.appendData(QVector<Point>() << a << b);
+        const QByteArray& bytes = source.serialize();
+
+        PointModel copy;
+        QSignalSpy reset(&copy, SIGNAL(modelReset()));
+        copy.unserialize(bytes);
+        QCOMPARE(reset.count(), 1);
+        QCOMPARE(labels(copy), QStringList() << "a" << "b");
+        QCOMPARE(copy.value<PointModel::Field::x>(1), 3);
+        QCOMPARE(copy.value<PointModel::Field::y>(1), 4);
+
+        /**
+          * Truncated rows, a count above the rows present and a huge count are corrupt,
+          * the model keeps its rows
+          */
+        PointModel other;
+        other.appendData(c);
+        QSignalSpy otherReset(&other, SIGNAL(modelReset()));
+        other.unserialize(bytes.left(bytes.size() - 1));
+        QByteArray more = bytes;
+        more[3] = char(3);
+        other.unserialize(more);
+        QByteArray huge;
+        {
+            QDataStream s(&huge, QIODevice::WriteOnly);
+            s << quint32(0xFFFFFFFF);
+        }
+        other.unserialize(huge);
+        QVERIFY(otherReset.isEmpty());
+        QCOMPARE(labels(other), QStringList() << "c");
+    }
+
+    void internedRoles(){
+        ItemModel model;
+        /**
+          * Each row holds its own copy of an equal category
+          */
+        model.appendData(QList<Item*>()
+                         << new Item("a", QString::fromLatin1("fruit"))
+                         << new Item("b", QString::fromLatin1("fruit"))
+                         << new Item("c", QString::fromLatin1("fruit")));
+        QVERIFY(model.value<ItemCategoryRole>(0).constData() != model.value<ItemCategoryRole>(1).constData());
+
+        model.setInternedRoles(QStringList() << "category" << "number");
+        QCOMPARE(model.internedRoles(), QStringList() << "category");
+        QVERIFY(model.stringPool("name") == Q_NULLPTR);
+        QVERIFY(model.stringPool("category") != Q_NULLPTR);
+        QCOMPARE(model.stringPool("category")->size(), 1);
+        QCOMPARE(model.value<ItemCategoryRole>(0).constData(), model.value<ItemCategoryRole>(1).constData());
+        QCOMPARE(model.value<ItemCategoryRole>(0).constData(), model.value<ItemCategoryRole>(2).constData());
+
+        /**
+          * Inserted and changed values join the pool
+          */
+        model.appendData(new Item("d", QString::fromLatin1("vegetable")));
+        QVERIFY(model.setValue<ItemCategoryRole>(0, QString::fromLatin1("vegetable")));
+        QCOMPARE(model.stringPool("category")->size(), 2);
+        QCOMPARE(model.value<ItemCategoryRole>(0).constData(), model.value<ItemCategoryRole>(3).constData());
+        QCOMPARE(model.value<ItemCategoryRole>(0), QStringLiteral("vegetable"));
+
+        /**
+          * The pool keeps a value until its last row is deleted and the pools are squeezed
+          */
+        QVERIFY(model.removeData(3));
+        QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+        QCOMPARE(model.squeezeStringPools(), 0);
+        QVERIFY(model.removeData(0));
+        QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+        QCOMPARE(model.squeezeStringPools(), 1);
+        QCOMPARE(model.stringPool("category")->size(), 1);
+        QCOMPARE(names(model), QStringList() << "b" << "c");
+
+        model.setInternedRoles(QStringList());
+        QVERIFY(model.internedRoles().isEmpty());
+        QCOMPARE(model.squeezeStringPools(), 0);
+    }
+
+    void windowedAppend(){
+        ItemModel model;
+        model.setWindow(3);
+        QCOMPARE(model.window(), 3);
+        QStringList events;
+        connect(&model, &QAbstractItemModel::rowsRemoved, [&events](const QModelIndex&, int first, int last){
+            events.append(QString("removed %1 %2").arg(first).arg(last));
+        });
+        connect(&model, &QAbstractItemModel::rowsInserted, [&events](const QModelIndex&, int first, int last){
+            events.append(QString("inserted %1 %2").arg(first).arg(last));
+        });
+
+        /**
+          * The rows queued past the window are never inserted
+          */
+        for(int i = 0; i < 5; ++i)
+            model.appendWindowed(new Item(QString::number(i), QString(), i));
+        QCOMPARE(model.rowCount(QModelIndex()), 0);
+        model.flushWindow();
+        QCOMPARE(events, QStringList() << "inserted 0 2");
+        QCOMPARE(numbers(model), QVector<int>() << 2 << 3 << 4);
+
+        /**
+          * The event loop evicts the head with one removal and one insertion
+          */
+        events.clear();
+        model.appendWindowed(new Item("5", QString(), 5));
+        model.appendWindowed(new Item("6", QString(), 6));
+        QVERIFY(events.isEmpty());
+        QTRY_COMPARE(events, QStringList() << "removed 0 1" << "inserted 1 2");
+        QCOMPARE(numbers(model), QVector<int>() << 4 << 5 << 6);
+
+        /**
+          * Up to a window of the dropped rows are kept for reuse, the latest first
+          */
+        Item* row = model.recycledRow();
+        QCOMPARE(row->mNumber, 2);
+        row->mNumber = 7;
+        model.appendWindowed(row);
+        model.flushWindow();
+        QCOMPARE(numbers(model), QVector<int>() << 5 << 6 << 7);
+        Item* evicted = model.recycledRow();
+        QCOMPARE(evicted->mNumber, 4);
+        delete evicted;
+    }
+
+    void joinModel(){
+        ItemModel left, right;
+        left.appendData(QList<Item*>() << new Item("a", "x") << new Item("b", "y") << new Item("c", "z"));
+        right.appendData(QList<Item*>() << new Item("x", QString(), 10) << new Item("y", QString(), 20));
+        QmlListJoinModel join;
+        join.setLeftModel(&left);
+        join.setRightModel(&right);
+        join.setLeftKey(QStringLiteral("category"));
+        join.setRightKey(QStringLiteral("name"));
+        join.setRightPrefix(QStringLiteral("right_"));
+        const int rightNumber = QmlListJoinModel::RightRoleOffset + ItemNumberRole::role();
+        QCOMPARE(join.rowCount(), 3);
+        QCOMPARE(join.roleNames().value(rightNumber), QByteArrayLiteral("right_number"));
+        QCOMPARE(join.roleNames().value(QmlListJoinModel::JoinedRole), QByteArrayLiteral("joined"));
+        QCOMPARE(join.data(join.index(0), ItemNameRole::role()).toString(), QStringLiteral("a"));
+        QCOMPARE(join.data(join.index(1), rightNumber).toInt(), 20);
+        QVERIFY(join.data(join.index(0), QmlListJoinModel::JoinedRole).toBool());
+        QVERIFY(!join.data(join.index(2), QmlListJoinModel::JoinedRole).toBool());
+        QVERIFY(!join.data(join.index(2), rightNumber).isValid());
+
+        /**
+          * A left change without the key is one range of its roles
+          */
+        QSignalSpy changed(&join, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+        QVERIFY(left.setValues<ItemNumberRole>(0, QVector<int>() << 1 << 2 << 3));
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(takeChanged(changed), QString("0 2 [%1]").arg(ItemNumberRole::role()));
+
+        /**
+          * The rejoined rows change all their roles, the others keep the range roles
+          */
+        QVERIFY(left.setValues<ItemCategoryRole>(0, QVector<QString>() << "y" << "x" << "z"));
+        QCOMPARE(changed.count(), 2);
+        QCOMPARE(takeChanged(changed), QString("0 1 []"));
+        QCOMPARE(takeChanged(changed), QString("2 2 [%1]").arg(ItemCategoryRole::role()));
+        QCOMPARE(join.data(join.index(0), rightNumber).toInt(), 20);
+        QCOMPARE(join.data(join.index(1), rightNumber).toInt(), 10);
+
+        /**
+          * A right change notifies the left rows joined to it
+          */
+        QVERIFY(right.setValue<ItemNumberRole>(0, 11));
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(takeChanged(changed), QString("1 1 [%1,%2]").arg(rightNumber).arg(int(QmlListJoinModel::JoinedRole)));
+        QCOMPARE(join.data(join.index(1), rightNumber).toInt(), 11);
+
+        /**
+          * A right key change rejoins the rows of the old and the new key
+          */
+        QVERIFY(right.setValue<ItemNameRole>(1, QStringLiteral("z")));
+        QStringList rejoined;
+        while(!changed.isEmpty())
+            rejoined.append(takeChanged(changed));
+        rejoined.sort();
+        QCOMPARE(rejoined, QStringList() << "0 0 []" << "2 2 []");
+        QVERIFY(!join.data(join.index(0), QmlListJoinModel::JoinedRole).toBool());
+        QCOMPARE(join.data(join.index(2), rightNumber).toInt(), 20);
+    }
+};
+
+QTEST_GUILESS_MAIN(QmlListModelTest)
+
+#include "tst_qmllistmodel.moc"